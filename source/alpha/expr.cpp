@@ -93,6 +93,11 @@ namespace alpha
 
 
 
+	Expr* toAndNot(Expr* expr)
+	{
+		return transform(expr);
+	}
+
 	void Graph::setAst(Expr* expr)
 	{
 		auto t = transform(expr);
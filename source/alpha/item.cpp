@@ -101,6 +101,26 @@ namespace alpha
 
 		return eq;
 	}
+
+	std::string canonicalGraph(const Item* item)
+	{
+		// the length goes first, so that no name can look like a bracket.
+		if(!item->isBox)
+			return zpr::sprint("{}:{}", item->name.size(), item->name);
+
+		// the things in a cut aren't in any particular order, so they get sorted.
+		auto subs = std::vector<std::string>();
+		for(auto child : item->subs)
+			subs.push_back(canonicalGraph(child));
+
+		std::sort(subs.begin(), subs.end());
+
+		auto ret = std::string("(");
+		for(auto& s : subs)
+			ret += s;
+
+		return ret + ")";
+	}
 }
 
 
@@ -85,6 +85,10 @@ namespace alpha
 		Graph& operator= (const Graph&) = delete;
 	};
 
+	// rewrites the ors and implications with ands and nots, which is all that graphs (and the
+	// solver) know about. returns a new expression, and leaves the old one alone.
+	ast::Expr* toAndNot(ast::Expr* expr);
+
 	void eraseItemFromParent(Graph* graph, Item* item);
 
 	// inference rules
@@ -104,6 +108,10 @@ namespace alpha
 	bool canIterateInto(Graph* graph, const Item* selection);
 	bool areGraphsEquivalent(const Item* a, const Item* b);
 
+	// the same string for graphs that are the same up to the order of things inside each cut, and
+	// different strings for any others.
+	std::string canonicalGraph(const Item* item);
+
 	std::set<const Item*> getDeiterationTargets(Graph* graph);
 
 	// guard functions, because the UI needs to be able to grey out
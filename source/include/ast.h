@@ -117,6 +117,11 @@ namespace ast
 		Expr* left = 0;
 		Expr* right = 0;
 	};
+
+	// kleene's three-valued logic, where an unassigned variable is unknown (see solver::Evaluator).
+	constexpr int TRI_FALSE     = 0;
+	constexpr int TRI_TRUE      = 1;
+	constexpr int TRI_UNKNOWN   = 2;
 }
 
 namespace parser
@@ -0,0 +1,709 @@
+// solver.h
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <functional>
+
+#include "defs.h"
+
+namespace ast
+{
+	struct Expr;
+}
+
+namespace solver
+{
+	// the operands of a chain of ands (graphs turn into long left-leaning ones), in order.
+	void flattenAnd(const ast::Expr* expr, std::vector<const ast::Expr*>& out);
+
+	// indices into `vars` in order of first appearance; if `everything`, the missing ones go on the end.
+	std::vector<uint32_t> firstAppearanceOrder(const ast::Expr* expr, const std::vector<std::string>& vars,
+		bool everything);
+
+	// an and/not expression flattened into ops that only read earlier slots; the result is the last slot.
+	// each slot is 64 lanes, so one pass checks 64 assignments at once.
+	struct Tape
+	{
+		static constexpr uint8_t OP_VAR     = 1;    // a: variable index
+		static constexpr uint8_t OP_CONST   = 2;    // a: 0 or 1
+		static constexpr uint8_t OP_AND     = 3;    // a, b: operand slots
+		static constexpr uint8_t OP_NOT     = 4;    // a: operand slot
+
+		struct Op
+		{
+			uint8_t kind;
+			uint32_t a;
+			uint32_t b;
+		};
+
+		size_t numVars = 0;
+		std::vector<Op> ops;
+
+		// `vars` holds one word per variable, and `slots` must have space for ops.size() words.
+		uint64_t run(const uint64_t* vars, uint64_t* slots) const;
+
+		// `vars` determines the variable numbering; every variable in the expression must be in it.
+		static Tape compile(const ast::Expr* expr, const std::vector<std::string>& vars);
+
+		// assignment i gives variable k bit k of i; block b is assignments [64b, 64b + 64).
+		static uint64_t numBlocks(size_t num_vars);
+		static uint64_t laneMask(size_t num_vars);
+		static void loadBlock(uint64_t* vars, size_t num_vars, uint64_t block);
+	};
+
+	// runs fn(task, worker) for every task in [0, num_tasks) with work-stealing; stops early if fn returns false.
+	void parallelFor(uint64_t num_tasks, size_t num_workers,
+		const std::function<bool (uint64_t task, size_t worker)>& fn);
+
+	// std::thread::hardware_concurrency(), but never 0.
+	size_t numHardwareThreads();
+
+	// solver work on its own thread; progress and cancellation are atomic so the ui can poll them.
+	// a total of 0 means we can't tell how far along it is.
+	struct Job
+	{
+		void cancel() { this->cancelled.store(true); }
+		bool isCancelled() const { return this->cancelled.load(); }
+		bool isFinished() const { return this->finished.load(); }
+
+		void setProgress(uint64_t done, uint64_t total);
+		std::pair<uint64_t, uint64_t> progress() const { return { this->done.load(), this->total.load() }; }
+
+		// for hooking up to Cursor::interrupt and friends; the job has to outlive them.
+		std::function<bool ()> interruptor();
+		std::function<void (uint64_t, uint64_t)> reporter();
+
+		double elapsed() const;
+
+		// progress per second, and the seconds left at that rate; both are < 0 if we can't tell.
+		double rate() const;
+		double remaining() const;
+
+	private:
+		friend struct JobRunner;
+
+		std::atomic<bool> cancelled { false };
+		std::atomic<bool> finished { false };
+		std::atomic<uint64_t> done { 0 };
+		std::atomic<uint64_t> total { 0 };
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+	};
+
+	// runs jobs on other threads; the callback each one returns gets run by poll(), on the ui thread.
+	struct JobRunner
+	{
+		using Work = std::function<std::function<void ()> (Job& job)>;
+
+		JobRunner() = default;
+		~JobRunner();
+
+		JobRunner(const JobRunner&) = delete;
+		JobRunner& operator= (const JobRunner&) = delete;
+
+		std::shared_ptr<Job> start(Work work);
+		void poll();
+
+		// cancels everything that's still running and waits for it; the callbacks don't get run.
+		void stop();
+
+	private:
+		std::mutex lock;
+		std::vector<std::pair<std::shared_ptr<Job>, std::function<void ()>>> completed;
+
+		// only touched by the thread that starts and polls.
+		std::vector<std::pair<std::shared_ptr<Job>, std::thread>> running;
+	};
+
+	// the value of every variable, one bit each; variable i is bit (i % 64) of word (i / 64).
+	struct Assignment
+	{
+		Assignment() { }
+		explicit Assignment(size_t num_vars) : nvars(num_vars), words((num_vars + 63) / 64, 0) { }
+
+		size_t size() const { return this->nvars; }
+
+		bool get(size_t i) const { return (this->words[i / 64] >> (i % 64)) & 1; }
+		void set(size_t i, bool value)
+		{
+			if(value)   this->words[i / 64] |= (1ULL << (i % 64));
+			else        this->words[i / 64] &= ~(1ULL << (i % 64));
+		}
+
+		bool operator== (const Assignment& other) const { return this->nvars == other.nvars && this->words == other.words; }
+		bool operator!= (const Assignment& other) const { return !(*this == other); }
+
+		size_t nvars = 0;
+		std::vector<uint64_t> words;
+	};
+
+	// like an assignment, but variables can also be left unassigned.
+	struct PartialAssignment
+	{
+		PartialAssignment() { }
+		explicit PartialAssignment(size_t num_vars) : values(num_vars), assigned(num_vars) { }
+
+		// every variable is assigned.
+		explicit PartialAssignment(const Assignment& full) : values(full), assigned(full.size())
+		{
+			for(auto& w : this->assigned.words)
+				w = ~0ULL;
+
+			if(auto extra = full.size() % 64; extra != 0)
+				this->assigned.words.back() = (1ULL << extra) - 1;
+		}
+
+		size_t size() const { return this->values.size(); }
+
+		bool isAssigned(size_t i) const { return this->assigned.get(i); }
+		bool get(size_t i) const { return this->values.get(i); }
+
+		void set(size_t i, bool value) { this->values.set(i, value); this->assigned.set(i, true); }
+		void unset(size_t i) { this->values.set(i, false); this->assigned.set(i, false); }
+
+		bool operator== (const PartialAssignment& other) const
+		{
+			return this->values == other.values && this->assigned == other.assigned;
+		}
+
+		bool operator!= (const PartialAssignment& other) const { return !(*this == other); }
+
+		// unassigned variables are always false here, so that == works.
+		Assignment values;
+		Assignment assigned;
+	};
+
+	// the three-valued result (ast::TRI_*) of every subexpression, so changing a variable only
+	// re-evaluates what's above it. variable k is vars[k].
+	struct Evaluator
+	{
+		Evaluator() { }
+		Evaluator(const ast::Expr* expr, const std::vector<std::string>& vars);
+
+		// brings everything up to date with `assigns`; `changed` gets the variables that differed.
+		void update(const PartialAssignment& assigns, std::vector<uint32_t>& changed);
+
+		// changes just the one variable.
+		void set(uint32_t var, bool value);
+		void unset(uint32_t var);
+
+		// the value of the whole expression.
+		int result() const;
+
+		// roughly how many bytes this is holding on to.
+		size_t memoryUsage() const;
+
+	private:
+		struct Node
+		{
+			uint8_t kind;
+			uint8_t value;
+			uint32_t a;         // variable index, literal value, or operand node
+			uint32_t b;
+			uint32_t parent;
+		};
+
+		std::vector<Node> nodes;
+		std::vector<std::vector<uint32_t>> occurrences;
+		PartialAssignment current;
+
+		uint32_t add(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices);
+		uint8_t compute(const Node& node) const;
+		void assign(uint32_t var, uint8_t value);
+	};
+
+	// a literal is 2*var for the positive polarity, and 2*var + 1 for the negative one.
+	using Lit = uint32_t;
+
+	inline Lit mkLit(uint32_t var, bool neg = false) { return 2 * var + (neg ? 1 : 0); }
+	inline uint32_t litVar(Lit lit) { return lit >> 1; }
+	inline bool litNeg(Lit lit) { return lit & 1; }
+	inline Lit negate(Lit lit) { return lit ^ 1; }
+
+	struct SatState;
+
+	// a cdcl sat solver. clauses can be added between calls to solve(), which is how models get enumerated.
+	struct Sat
+	{
+		static constexpr int RESULT_UNKNOWN = 0;    // interrupted before we found out
+		static constexpr int RESULT_SAT     = 1;
+		static constexpr int RESULT_UNSAT   = 2;
+
+		Sat();
+		~Sat();
+
+		Sat(const Sat&) = delete;
+		Sat& operator= (const Sat&) = delete;
+
+		uint32_t newVar();
+		size_t numVars() const;
+
+		// returns false if the clauses are now trivially unsatisfiable.
+		bool addClause(std::vector<Lit> lits);
+
+		// the assumptions are treated as temporary unit clauses, for this call only.
+		int solve(const std::vector<Lit>& assumptions = { });
+
+		// only valid after solve() returns RESULT_SAT.
+		bool modelValue(uint32_t var) const;
+
+		// roughly how many bytes the clauses (including learnt ones) and the per-variable state take.
+		size_t memoryUsage() const;
+
+		// polled every so often during the search; return true to give up.
+		std::function<bool ()> interrupt;
+
+		uint64_t conflicts = 0;
+		uint64_t decisions = 0;
+
+	private:
+		SatState* state;
+	};
+
+	// tseitin-encodes the expression; returns a literal that's true when it is. variable i of `vars` is sat variable i.
+	Lit encodeTseitin(Sat& sat, const ast::Expr* expr, const std::vector<std::string>& vars);
+
+	// bit i is whether sat variable i is in the xor, and bit n is its parity.
+	using XorRow = std::vector<uint64_t>;
+	std::vector<XorRow> randomXors(std::mt19937_64& rng, size_t num_vars, size_t count);
+
+	// puts the xors in reduced row echelon form before encoding them, since the sat solver can't add them up.
+	void addXors(Sat& sat, std::vector<XorRow> rows, size_t num_vars);
+
+	constexpr int EQUIV_UNKNOWN     = 0;    // interrupted before we found out
+	constexpr int EQUIV_SAME        = 1;
+	constexpr int EQUIV_DIFFERENT   = 2;
+
+	// whether two expressions are the same function of `vars`, via a structurally hashed miter;
+	// if not, `witness` is where they differ.
+	int checkEquivalence(const ast::Expr* a, const ast::Expr* b, const std::vector<std::string>& vars,
+		Assignment* witness, const std::function<bool ()>& interrupt = {});
+
+	// an unsigned arbitrary-precision integer, since solution counts easily go past 2^64.
+	struct BigNum
+	{
+		BigNum() { }
+		BigNum(uint64_t x);
+
+		BigNum operator+ (const BigNum& other) const;
+		BigNum operator* (const BigNum& other) const;
+		BigNum operator<< (size_t shift) const;
+
+		// there are no negative numbers, so `other` can't be bigger than this.
+		BigNum operator- (const BigNum& other) const;
+
+		BigNum& operator+= (const BigNum& other) { return (*this = *this + other); }
+		BigNum& operator-= (const BigNum& other) { return (*this = *this - other); }
+		BigNum& operator*= (const BigNum& other) { return (*this = *this * other); }
+
+		bool operator== (const BigNum& other) const { return this->limbs == other.limbs; }
+		bool operator!= (const BigNum& other) const { return this->limbs != other.limbs; }
+		bool operator< (const BigNum& other) const;
+		bool operator<= (const BigNum& other) const { return !(other < *this); }
+
+		bool isZero() const { return this->limbs.empty(); }
+		bool fitsU64() const { return this->limbs.size() <= 2; }
+
+		// these truncate if the number doesn't fit.
+		uint64_t u64() const;
+		double f64() const;
+
+		std::string str() const;
+
+	private:
+		// little-endian, and never has trailing zero limbs (so zero is empty).
+		std::vector<uint32_t> limbs;
+		void trim();
+	};
+
+	// a robdd manager; variable i is at level i. only ref()'d nodes survive collectGarbage().
+	struct Bdd
+	{
+		using Node = uint32_t;
+
+		static constexpr Node FALSE = 0;
+		static constexpr Node TRUE  = 1;
+
+		Bdd(size_t num_vars, size_t max_nodes = 1 << 23);
+
+		Bdd(const Bdd&) = delete;
+		Bdd& operator= (const Bdd&) = delete;
+
+		size_t numVars() const { return this->nvars; }
+		size_t numNodes() const { return this->live; }
+		size_t memoryUsage() const;
+
+		Node var(uint32_t v);
+		Node ite(Node f, Node g, Node h);
+
+		Node bddNot(Node f) { return this->ite(f, FALSE, TRUE); }
+		Node bddAnd(Node f, Node g) { return this->ite(f, g, FALSE); }
+
+		void ref(Node n);
+		void deref(Node n);
+		void collectGarbage();
+
+		// returns false if it outgrew max_nodes or was interrupted; the result is already ref()'d.
+		bool build(const ast::Expr* expr, const std::vector<std::string>& vars, Node* out);
+
+		// the number of assignments (over all the variables) that make `f` true.
+		BigNum satCount(Node f);
+
+		// the `index`-th satisfying assignment of `f` (by level), in lexicographic order.
+		void solution(Node f, uint64_t index, Assignment& out);
+
+		// a uniformly random satisfying assignment of `f` (indexed by level); `f` can't be FALSE.
+		void randomSolution(Node f, std::mt19937_64& rng, Assignment& out);
+
+		// an irredundant prime cover of `f` (minato-morreale), up to `max_cubes` cubes indexed by level.
+		bool cover(Node f, std::vector<PartialAssignment>* out, size_t max_cubes = SIZE_MAX);
+
+		// polled while building; return true to give up.
+		std::function<bool ()> interrupt;
+
+		// called with (done, total) after each top-level conjunct is built.
+		std::function<void (size_t, size_t)> progress;
+
+	private:
+		struct NodeData
+		{
+			uint32_t var;
+			Node lo;
+			Node hi;
+			Node next;      // the next node in the same unique-table bucket (or the free list)
+		};
+
+		struct CacheEntry
+		{
+			Node f;
+			Node g;
+			Node h;
+			Node result;
+		};
+
+		size_t nvars;
+		size_t maxNodes;
+		size_t live = 0;
+		size_t gcThreshold;
+		size_t steps = 0;
+		bool failed = false;
+
+		Node freeList;
+		std::vector<NodeData> nodes;
+		std::vector<uint32_t> refs;
+		std::vector<Node> buckets;
+		std::vector<CacheEntry> cache;
+		std::unordered_map<Node, BigNum> counts;
+
+		uint32_t level(Node n) const { return this->nodes[n].var; }
+		Node mk(uint32_t var, Node lo, Node hi);
+		void rehash(size_t num_buckets);
+		Node buildExpr(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices);
+		const BigNum& countBelow(Node n);
+		Node isop(Node lower, Node upper, PartialAssignment& cube, std::vector<PartialAssignment>* out, size_t max_cubes);
+	};
+
+	// counts solutions without enumerating them, caching independent subproblems.
+	// returns false if it ran out of room or was interrupted.
+	bool countModels(const ast::Expr* expr, const std::vector<std::string>& vars, BigNum* out,
+		const std::function<bool ()>& interrupt = { }, size_t max_nodes = 1 << 22);
+
+	// an (epsilon, delta) estimate of the count, using random xors (as in approxmc); `exact` is set
+	// if there were few enough to just count. returns false if interrupted.
+	bool approxCount(const ast::Expr* expr, const std::vector<std::string>& vars, double epsilon, double delta,
+		uint64_t seed, BigNum* out, bool* exact, const std::function<bool ()>& interrupt = { },
+		const std::function<void (uint64_t, uint64_t)>& progress = { });
+
+	// like Bdd::cover(), but with the sat solver; every cube is prime, but some might be redundant.
+	bool satCover(const ast::Expr* expr, const std::vector<std::string>& vars, std::vector<PartialAssignment>* out,
+		size_t max_cubes = SIZE_MAX, const std::function<bool ()>& interrupt = { });
+
+	// the solution whose true variables have the smallest total weight (branch and bound).
+	// returns one of the Sat::RESULT_* values.
+	int minimiseWeight(const ast::Expr* expr, const std::vector<std::string>& vars, const std::vector<int64_t>& weights,
+		Assignment* out, int64_t* cost, const std::function<bool ()>& interrupt = { });
+
+	// the variables that are the same in every solution (that agrees with the pins) go in `out`.
+	// returns one of the Sat::RESULT_* values.
+	int findBackbone(const ast::Expr* expr, const std::vector<std::string>& vars, const PartialAssignment& pins,
+		PartialAssignment* out, const std::function<bool ()>& interrupt = { });
+
+	// walks through the solutions one at a time, finding each only when asked; they're numbered from 0,
+	// and values() is in the order of the `vars` it was made with.
+	struct Cursor
+	{
+		static constexpr int STEP_ABORTED   = 0;    // interrupted; the cursor didn't move
+		static constexpr int STEP_FOUND     = 1;
+		static constexpr int STEP_END       = 2;    // nothing more in that direction
+
+		virtual ~Cursor() { }
+
+		// the first call to next() finds the first solution.
+		int next();
+		int prev();
+
+		bool valid() const { return this->hasCurrent; }
+		uint64_t index() const { return this->position; }
+		const Assignment& values() const { return this->current; }
+
+		virtual bool hasPrev() const { return this->hasCurrent && this->position > 0; }
+		virtual bool hasNext() const;
+
+		// returns false if we don't know the total number of solutions (yet).
+		virtual bool count(BigNum* out) const;
+
+		// random samples (see sampleCursor()) aren't the solutions in any order, so they can't
+		// stand in for them.
+		virtual bool isSample() const { return false; }
+
+		// roughly how many bytes this is holding on to, including whatever it found along the way.
+		virtual size_t memoryUsage() const { return sizeof(Cursor) + 8 * this->current.words.size(); }
+
+		// enough to resume a search, even in another run: the solution we were on, and how far past it we've looked.
+		struct Checkpoint
+		{
+			bool hasCurrent = false;
+			uint64_t position = 0;
+			uint64_t row = 0;
+			uint64_t scanned = 0;
+
+			// for a product (see productCursor), where each part is and which way it's going.
+			std::vector<Checkpoint> parts;
+			std::vector<bool> reversed;
+		};
+
+		// only the brute-force cursors (and products of them) can do this; the rest return false. resume() only works on
+		// a new cursor, made for the same expression in the same way.
+		bool save(Checkpoint* out) const;
+		bool resume(const Checkpoint& cp);
+
+		// polled during a step; return true to give up.
+		std::function<bool ()> interrupt;
+
+		// called with (done, total) assignments checked while stepping; a total of 0 means we can't tell.
+		std::function<void (uint64_t, uint64_t)> progress;
+
+		// called (on the stepping thread) whenever a search gets further along, ie. when save() would
+		// have something new to say.
+		std::function<void ()> onFrontier;
+
+	protected:
+		// these fill in `current`; forward() should find the first solution if !hasCurrent.
+		virtual int forward() = 0;
+		virtual int backward() = 0;
+
+		// the cursor-specific parts of a checkpoint (row and scanned); the rest is already done.
+		virtual bool saveFrontier(Checkpoint* out) const { return false; }
+		virtual bool loadFrontier(const Checkpoint& cp) { return false; }
+
+		bool hasCurrent = false;
+		uint64_t position = 0;
+		Assignment current;
+
+		// set once next() runs off the end, at which point we know how many there are.
+		bool exhausted = false;
+		uint64_t total = 0;
+	};
+
+	// the last few solutions found by a cursor that can only go forwards, so that prev() can go
+	// back over them without them piling up; anything older than that is forgotten.
+	struct RecentSolutions
+	{
+		static constexpr size_t LIMIT = 256;
+
+		// solutions are added in order, so `position` is always one past the newest.
+		void push(uint64_t position, const Assignment& soln)
+		{
+			if(this->ring.size() < LIMIT)   this->ring.push_back(soln);
+			else                            this->ring[position % LIMIT] = soln;
+
+			this->end = position + 1;
+		}
+
+		bool has(uint64_t position) const { return position < this->end && this->end - position <= this->ring.size(); }
+		const Assignment& get(uint64_t position) const { return this->ring[position % LIMIT]; }
+
+		// as much as this will ever hold, so that it can be counted up front.
+		static size_t memoryUsage(size_t num_vars) { return LIMIT * (sizeof(Assignment) + 8 * ((num_vars + 63) / 64)); }
+
+	private:
+		std::vector<Assignment> ring;
+		uint64_t end = 0;
+	};
+
+	// a search saved to disk so it can be resumed later; `key` and `engine` are up to whoever made it.
+	struct SavedSearch
+	{
+		std::string key;
+		uint32_t engine = 0;
+		PartialAssignment pins;
+		Cursor::Checkpoint cursor;
+	};
+
+	// these go through a temporary file, so a crash halfway through won't leave a broken one behind.
+	bool writeSavedSearch(const std::string& path, const SavedSearch& search);
+	bool readSavedSearch(const std::string& path, SavedSearch* out);
+
+	// runs brute-force scans in worker processes (this program, with `--solver-worker <fd>`), so that
+	// a worker crashing doesn't take the ui down with it. can be shared between cursors.
+	struct WorkerPool
+	{
+		WorkerPool(std::string program, size_t num_workers);
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator= (const WorkerPool&) = delete;
+
+		size_t size() const { return this->workers.size(); }
+
+		// each cursor's tape gets a different id, so that a worker only gets sent a tape once.
+		uint64_t newTapeId() { return ++this->lastTapeId; }
+
+		// scans blocks first + i (or first - i) for i in [begin, end); `best` gets the smallest i with a
+		// solution. returns false if interrupted, or if every worker died.
+		struct Scan
+		{
+			uint64_t first = 0;
+			bool forward = true;
+			uint64_t begin = 0;
+			uint64_t end = 0;
+			uint64_t chunk = 0;
+			uint64_t firstMask = 0;
+		};
+
+		bool scan(uint64_t tape_id, const Tape& tape, const Scan& scan, uint64_t* best,
+			const std::function<bool ()>& interrupt, const std::function<void (uint64_t)>& done);
+
+	private:
+		struct Worker
+		{
+			int pid = -1;
+			int fd = -1;
+			uint64_t tapeId = 0;
+
+			bool busy = false;
+			uint64_t chunk = 0;
+		};
+
+		bool spawn(Worker& worker);
+		void kill(Worker& worker);
+		bool send(Worker& worker, uint64_t tape_id, const Tape& tape, const Scan& scan, uint64_t chunk);
+
+		std::string program;
+		std::vector<Worker> workers;
+		std::atomic<uint64_t> lastTapeId { 0 };
+
+		// one scan at a time; a cursor that's been cancelled might still be finishing one off.
+		std::mutex lock;
+	};
+
+	// the other end of a WorkerPool; runs until the socket closes, and returns the exit code.
+	int runWorker(int fd);
+
+	// the brute-force cursors number the assignments with a 64-bit counter, so they can't go past this.
+	constexpr size_t MAX_BRUTE_FORCE_VARS = 64;
+
+	// goes through every assignment in order, 64 at a time on `num_workers` threads.
+	// returns null if there are more than MAX_BRUTE_FORCE_VARS variables (as do the two below).
+	Cursor* bruteForceCursor(const ast::Expr* expr, const std::vector<std::string>& vars, size_t num_workers);
+
+	// the same, but with the scanning done by the processes in `pool`.
+	Cursor* processCursor(const ast::Expr* expr, const std::vector<std::string>& vars,
+		std::shared_ptr<WorkerPool> pool);
+
+	// goes through the assignments in gray code order, re-evaluating only what each flip changes.
+	Cursor* grayCodeCursor(const ast::Expr* expr, const std::vector<std::string>& vars);
+
+	// each solution is a fresh sat call with the earlier ones blocked; the pins are assumptions.
+	Cursor* satCursor(const ast::Expr* expr, const std::vector<std::string>& vars,
+		const PartialAssignment& pins = PartialAssignment());
+
+	// like satCursor(), but only the variables in `shown` are blocked, so each solution is a new combination of those.
+	Cursor* projectedCursor(const ast::Expr* expr, const std::vector<std::string>& vars,
+		const PartialAssignment& pins, const std::vector<bool>& shown);
+
+	// unranks solutions straight out of the diagram, and takes ownership of the bdd. level i
+	// of the bdd is variable levels[i] of the cursor.
+	Cursor* bddCursor(Bdd* bdd, Bdd::Node root, const std::vector<uint32_t>& levels);
+
+	// `inner` enumerates the variables not assigned in `pins`, and this fills the pinned ones back in; owns `inner`.
+	Cursor* pinnedCursor(Cursor* inner, const PartialAssignment& pins);
+
+	// every combination of the parts' solutions; variable k of parts[i] is indices[i][k]. owns the parts.
+	Cursor* productCursor(std::vector<Cursor*> parts, std::vector<std::vector<uint32_t>> indices, size_t num_vars);
+
+	// draws random solutions for sampleCursor().
+	struct Sampler
+	{
+		virtual ~Sampler() { }
+
+		// fills in a random solution; returns one of the Sat::RESULT_* values.
+		virtual int draw(std::mt19937_64& rng, Assignment& out) = 0;
+
+		virtual size_t memoryUsage() const = 0;
+
+		// polled while drawing; return true to give up.
+		std::function<bool ()> interrupt;
+	};
+
+	// exactly uniform, straight out of the diagram; takes ownership of the bdd. level i of the bdd
+	// is variable levels[i] of the samples.
+	Sampler* bddSampler(Bdd* bdd, Bdd::Node root, const std::vector<uint32_t>& levels);
+
+	// near-uniform samples using random xors (as in unigen), for when the bdd would be too big.
+	Sampler* xorSampler(const ast::Expr* expr, const std::vector<std::string>& vars);
+
+	// `limit` random solutions, drawn as next() asks; the sampler only does the variables not in `pins`. owns the sampler.
+	Cursor* sampleCursor(Sampler* sampler, const PartialAssignment& pins, size_t limit, uint64_t seed);
+
+	// keeps the results of old solves (eg. for undo); the least recently used go once it's over the limit.
+	struct ResultCache
+	{
+		struct Entry
+		{
+			Cursor* cursor = nullptr;
+			bool counted = false;
+			BigNum count;
+		};
+
+		ResultCache(size_t max_bytes) : maxBytes(max_bytes) { }
+		~ResultCache();
+
+		ResultCache(const ResultCache&) = delete;
+		ResultCache& operator= (const ResultCache&) = delete;
+
+		// takes ownership of the entry's cursor, and replaces whatever was under `key` before.
+		void put(const std::string& key, Entry entry);
+
+		// removes the entry and hands it (and its cursor) back; returns false if there isn't one.
+		bool take(const std::string& key, Entry* out);
+
+		void setLimit(size_t max_bytes);
+		size_t memoryUsage() const { return this->used; }
+
+	private:
+		struct Slot
+		{
+			std::string key;
+			Entry entry;
+			size_t bytes;
+		};
+
+		// the most recently used are at the front.
+		std::list<Slot> slots;
+		std::unordered_map<std::string, std::list<Slot>::iterator> index;
+
+		size_t maxBytes;
+		size_t used = 0;
+
+		void evict();
+	};
+}
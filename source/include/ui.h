@@ -41,6 +41,15 @@ namespace ui
 	void editModeChanged(alpha::Graph* graph, bool active);
 	void evalModeChanged(alpha::Graph* graph, bool active);
 
+	// how much memory the results of old solves can take up before they start getting thrown out.
+	void setSolverCacheLimit(size_t bytes);
+
+	// where long searches get saved, so that they can be resumed later.
+	void setSavedSearchDir(const std::string& path);
+
+	// the program to run for the processes engine; it should be this one.
+	void setSolverWorkerProgram(const std::string& path);
+
 	bool toolEnabled(uint32_t tool);
 	void disableTool(uint32_t tool);
 	void enableTool(uint32_t tool);
@@ -254,6 +263,7 @@ namespace ui
 
 	// in sidebar.cpp
 	void toggleVariableState(int num);
+	void stopSolving();
 
 
 	namespace geometry
@@ -7,6 +7,7 @@
 
 #include "ui.h"
 #include "ast.h"
+#include "solver.h"
 
 // #include <GL/gl3w.h>
 #include <SDL2/SDL.h>
@@ -18,6 +19,11 @@
 #include "imgui/imgui_impl_sdl.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+#if defined(__APPLE__)
+	#include <mach-o/dyld.h>
+#elif defined(__linux__)
+	#include <unistd.h>
+#endif
 
 static bool quit = false;
 void ui::quit()
@@ -31,6 +37,27 @@ void ui::continueDrawing()
 	counter = 60;
 }
 
+#if !defined(__EMSCRIPTEN__)
+// argv[0] is only a path if we were started with one; if we came from $PATH, it's just the name.
+static std::string executable_path(const char* argv0)
+{
+#if defined(__linux__)
+	char buf[4096];
+	if(auto n = readlink("/proc/self/exe", buf, sizeof(buf)); n > 0 && (size_t) n < sizeof(buf))
+		return std::string(buf, (size_t) n);
+#elif defined(__APPLE__)
+	uint32_t size = 0;
+	_NSGetExecutablePath(nullptr, &size);
+
+	auto buf = std::string(size, '\0');
+	if(_NSGetExecutablePath(buf.data(), &size) == 0)
+		return std::string(buf.c_str());
+#endif
+
+	return argv0;
+}
+#endif
+
 #if defined(__EMSCRIPTEN__)
 static void main_loop_once()
 {
@@ -50,8 +77,28 @@ static void main_loop_once()
 
 int main(int argc, char** argv)
 {
-	(void) argc;
-	(void) argv;
+#if !defined(__EMSCRIPTEN__)
+	// the processes engine runs us again to do the searching; see solver::WorkerPool.
+	if(argc == 3 && std::string(argv[1]) == "--solver-worker")
+		return solver::runWorker((int) strtol(argv[2], nullptr, 10));
+
+	ui::setSolverWorkerProgram(executable_path(argv[0]));
+#endif
+
+	for(int i = 1; i < argc; i++)
+	{
+		auto arg = std::string(argv[i]);
+
+		// in megabytes
+		if(arg == "--solver-cache" && i + 1 < argc)
+			ui::setSolverCacheLimit((size_t) strtoull(argv[++i], nullptr, 10) * 1024 * 1024);
+
+		else if(arg == "--search-dir" && i + 1 < argc)
+			ui::setSavedSearchDir(argv[++i]);
+
+		else
+			lg::warn("main", "unknown argument '{}'", arg);
+	}
 
 	ui::init(/* title: */ "Peirce Alpha System");
 	ui::setup(argv[0], /* ui scale: */ 2, /* font size: */ 18.0, ui::dark());
@@ -0,0 +1,67 @@
+// backbone.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	int findBackbone(const ast::Expr* expr, const std::vector<std::string>& vars, const PartialAssignment& pins,
+		PartialAssignment* out, const std::function<bool ()>& interrupt)
+	{
+		auto sat = Sat();
+		sat.interrupt = interrupt;
+		sat.addClause({ encodeTseitin(sat, expr, vars) });
+
+		auto assumptions = std::vector<Lit>();
+		for(size_t i = 0; i < vars.size() && i < pins.size(); i++)
+		{
+			if(pins.isAssigned(i))
+				assumptions.push_back(mkLit((uint32_t) i, /* neg: */ !pins.get(i)));
+		}
+
+		auto result = sat.solve(assumptions);
+		if(result != Sat::RESULT_SAT)
+			return result;
+
+		// every variable starts out as a candidate, with the value it has in the first solution.
+		auto candidates = PartialAssignment(vars.size());
+		for(size_t i = 0; i < vars.size(); i++)
+			candidates.set(i, sat.modelValue((uint32_t) i));
+
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			if(!candidates.isAssigned(i))
+				continue;
+
+			// the pins are the same in every solution by definition.
+			if(i < pins.size() && pins.isAssigned(i))
+				continue;
+
+			assumptions.push_back(mkLit((uint32_t) i, /* neg: */ candidates.get(i)));
+			auto r = sat.solve(assumptions);
+			assumptions.pop_back();
+
+			if(r == Sat::RESULT_UNKNOWN)
+				return r;
+
+			if(r == Sat::RESULT_UNSAT)
+			{
+				// it can't be flipped, so it's in the backbone; later searches get to know that too.
+				sat.addClause({ mkLit((uint32_t) i, /* neg: */ !candidates.get(i)) });
+				continue;
+			}
+
+			// the new solution rules out everything else that it flipped as well.
+			for(size_t k = i; k < vars.size(); k++)
+			{
+				if(candidates.isAssigned(k) && candidates.get(k) != sat.modelValue((uint32_t) k))
+					candidates.unset(k);
+			}
+		}
+
+		*out = std::move(candidates);
+		return Sat::RESULT_SAT;
+	}
+}
@@ -0,0 +1,474 @@
+// bdd.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <cmath>
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	static constexpr uint32_t NONE         = UINT32_MAX;
+	static constexpr uint32_t DEAD_VAR     = UINT32_MAX;
+	static constexpr size_t MIN_CACHE_SIZE = 1 << 18;
+	static constexpr size_t MAX_CACHE_SIZE = 1 << 22;
+
+	static inline size_t hash3(uint32_t a, uint32_t b, uint32_t c)
+	{
+		uint64_t h = a;
+		h = h * 0x9E37'79B9'7F4A'7C15 + b;
+		h = h * 0x9E37'79B9'7F4A'7C15 + c;
+		return (size_t) (h ^ (h >> 29));
+	}
+
+	Bdd::Bdd(size_t num_vars, size_t max_nodes) : nvars(num_vars), maxNodes(max_nodes)
+	{
+		// the terminals sit below every variable.
+		this->nodes.push_back({ (uint32_t) num_vars, FALSE, FALSE, NONE });
+		this->nodes.push_back({ (uint32_t) num_vars, TRUE, TRUE, NONE });
+		this->refs.resize(2, 0);
+
+		this->freeList = NONE;
+		this->gcThreshold = std::min(max_nodes / 2, (size_t) 1 << 16);
+
+		this->buckets.resize(1 << 12, NONE);
+		this->cache.resize(MIN_CACHE_SIZE, CacheEntry { NONE, NONE, NONE, NONE });
+	}
+
+	void Bdd::rehash(size_t num_buckets)
+	{
+		this->buckets.clear();
+		this->buckets.resize(num_buckets, NONE);
+
+		for(Node n = 2; n < this->nodes.size(); n++)
+		{
+			auto& nd = this->nodes[n];
+			if(nd.var == DEAD_VAR)
+				continue;
+
+			auto h = hash3(nd.var, nd.lo, nd.hi) & (num_buckets - 1);
+			nd.next = this->buckets[h];
+			this->buckets[h] = n;
+		}
+
+		// a computed table that's much smaller than the diagram misses so often that ite()
+		// ends up redoing the same subproblems over and over, so grow it along with the nodes.
+		if(auto want = std::min(num_buckets, MAX_CACHE_SIZE); this->cache.size() < want)
+		{
+			this->cache.clear();
+			this->cache.resize(want, CacheEntry { NONE, NONE, NONE, NONE });
+		}
+	}
+
+	Bdd::Node Bdd::mk(uint32_t var, Node lo, Node hi)
+	{
+		if(lo == hi)
+			return lo;
+
+		auto h = hash3(var, lo, hi) & (this->buckets.size() - 1);
+		for(auto n = this->buckets[h]; n != NONE; n = this->nodes[n].next)
+		{
+			auto& nd = this->nodes[n];
+			if(nd.var == var && nd.lo == lo && nd.hi == hi)
+				return n;
+		}
+
+		if(this->failed)
+			return FALSE;
+
+		Node n = NONE;
+		if(this->freeList != NONE)
+		{
+			n = this->freeList;
+			this->freeList = this->nodes[n].next;
+		}
+		else if(this->nodes.size() < this->maxNodes)
+		{
+			n = (Node) this->nodes.size();
+			this->nodes.emplace_back();
+			this->refs.push_back(0);
+		}
+		else
+		{
+			this->failed = true;
+			return FALSE;
+		}
+
+		this->nodes[n] = { var, lo, hi, this->buckets[h] };
+		this->buckets[h] = n;
+		this->live += 1;
+
+		if(this->live > this->buckets.size())
+			this->rehash(2 * this->buckets.size());
+
+		return n;
+	}
+
+	Bdd::Node Bdd::var(uint32_t v)
+	{
+		return this->mk(v, FALSE, TRUE);
+	}
+
+	Bdd::Node Bdd::ite(Node f, Node g, Node h)
+	{
+		if(f == TRUE)   return g;
+		if(f == FALSE)  return h;
+		if(g == h)      return g;
+		if(g == TRUE && h == FALSE)
+			return f;
+
+		// poll here rather than in mk(), since a big operation can go a long time without
+		// allocating anything when most of its results are already in the unique table.
+		if((++this->steps % 65536) == 0 && this->interrupt && this->interrupt())
+			this->failed = true;
+
+		if(this->failed)
+			return FALSE;
+
+		auto hash = hash3(f, g, h);
+		if(auto& slot = this->cache[hash & (this->cache.size() - 1)]; slot.f == f && slot.g == g && slot.h == h)
+			return slot.result;
+
+		auto top = std::min({ this->level(f), this->level(g), this->level(h) });
+		auto cofactor = [this, top](Node n, bool high) -> Node {
+			if(this->level(n) != top)
+				return n;
+
+			return high ? this->nodes[n].hi : this->nodes[n].lo;
+		};
+
+		// read everything out first, since mk() can move the node array around.
+		auto f0 = cofactor(f, false);   auto f1 = cofactor(f, true);
+		auto g0 = cofactor(g, false);   auto g1 = cofactor(g, true);
+		auto h0 = cofactor(h, false);   auto h1 = cofactor(h, true);
+
+		auto hi = this->ite(f1, g1, h1);
+		auto lo = this->ite(f0, g0, h0);
+		auto ret = this->mk(top, lo, hi);
+
+		// mk() might have grown the cache, so look the slot up again.
+		if(!this->failed)
+			this->cache[hash & (this->cache.size() - 1)] = { f, g, h, ret };
+
+		return ret;
+	}
+
+	size_t Bdd::memoryUsage() const
+	{
+		// the counts are small, but every entry in an unordered_map is its own allocation.
+		return sizeof(Bdd)
+			+ this->nodes.size() * sizeof(NodeData)
+			+ this->refs.size() * sizeof(uint32_t)
+			+ this->buckets.size() * sizeof(Node)
+			+ this->cache.size() * sizeof(CacheEntry)
+			+ this->counts.size() * (sizeof(BigNum) + 32);
+	}
+
+	void Bdd::ref(Node n)
+	{
+		this->refs[n] += 1;
+	}
+
+	void Bdd::deref(Node n)
+	{
+		assert(this->refs[n] > 0);
+		this->refs[n] -= 1;
+	}
+
+	void Bdd::collectGarbage()
+	{
+		auto marked = std::vector<bool>(this->nodes.size(), false);
+		auto stack = std::vector<Node>();
+
+		for(Node n = 2; n < this->nodes.size(); n++)
+		{
+			if(this->refs[n] > 0)
+				stack.push_back(n);
+		}
+
+		while(!stack.empty())
+		{
+			auto n = stack.back();
+			stack.pop_back();
+
+			if(n < 2 || marked[n])
+				continue;
+
+			marked[n] = true;
+			stack.push_back(this->nodes[n].lo);
+			stack.push_back(this->nodes[n].hi);
+		}
+
+		this->live = 0;
+		this->freeList = NONE;
+		for(Node n = (Node) this->nodes.size() - 1; n >= 2; n--)
+		{
+			if(marked[n])
+			{
+				this->live += 1;
+				continue;
+			}
+
+			this->nodes[n].var = DEAD_VAR;
+			this->nodes[n].next = this->freeList;
+			this->freeList = n;
+		}
+
+		this->rehash(this->buckets.size());
+
+		for(auto& e : this->cache)
+			e = { NONE, NONE, NONE, NONE };
+
+		this->counts.clear();
+	}
+
+
+
+	Bdd::Node Bdd::buildExpr(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices)
+	{
+		if(this->failed)
+			return FALSE;
+
+		// this is the only place where it's safe to collect, since everything that's
+		// still needed further up the stack has been referenced.
+		if(this->live >= this->gcThreshold)
+		{
+			this->collectGarbage();
+			if(this->live >= this->gcThreshold / 2)
+				this->gcThreshold = std::min(this->maxNodes, 2 * this->gcThreshold);
+		}
+
+		if(auto l = dynamic_cast<const ast::Lit*>(expr); l != nullptr)
+		{
+			return l->value ? TRUE : FALSE;
+		}
+		else if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			auto it = indices.find(v->name);
+			if(it == indices.end())
+				lg::fatal("solver", "variable '{}' missing from the variable list", v->name);
+
+			return this->var(it->second);
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			return this->bddNot(this->buildExpr(n->e, indices));
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			// built one conjunct at a time so we can collect garbage in between.
+			auto conjuncts = std::vector<const ast::Expr*>();
+			flattenAnd(a, conjuncts);
+
+			Node acc = TRUE;
+			this->ref(acc);
+
+			for(auto c : conjuncts)
+			{
+				auto x = this->buildExpr(c, indices);
+				this->ref(x);
+
+				auto next = this->bddAnd(acc, x);
+				this->ref(next);
+				this->deref(acc);
+				this->deref(x);
+
+				acc = next;
+				if(acc == FALSE || this->failed)
+					break;
+			}
+
+			this->deref(acc);
+			return acc;
+		}
+		else
+		{
+			lg::fatal("solver", "invalid expression");
+		}
+	}
+
+	bool Bdd::build(const ast::Expr* expr, const std::vector<std::string>& vars, Node* out)
+	{
+		auto indices = std::unordered_map<std::string, uint32_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = (uint32_t) i;
+
+		// do the top level by hand, so we can report progress.
+		auto conjuncts = std::vector<const ast::Expr*>();
+		flattenAnd(expr, conjuncts);
+
+		Node acc = TRUE;
+		this->ref(acc);
+
+		for(size_t i = 0; i < conjuncts.size(); i++)
+		{
+			auto x = this->buildExpr(conjuncts[i], indices);
+			this->ref(x);
+
+			auto next = this->bddAnd(acc, x);
+			this->ref(next);
+			this->deref(acc);
+			this->deref(x);
+
+			acc = next;
+			if(this->progress)
+				this->progress(i + 1, conjuncts.size());
+
+			if(acc == FALSE || this->failed)
+				break;
+		}
+
+		if(this->failed)
+		{
+			this->deref(acc);
+			return false;
+		}
+
+		*out = acc;
+		return true;
+	}
+
+
+
+	const BigNum& Bdd::countBelow(Node n)
+	{
+		if(auto it = this->counts.find(n); it != this->counts.end())
+			return it->second;
+
+		BigNum ret;
+		if(n == TRUE)
+		{
+			ret = BigNum(1);
+		}
+		else if(n != FALSE)
+		{
+			auto lv = this->level(n);
+			auto lo = this->nodes[n].lo;
+			auto hi = this->nodes[n].hi;
+
+			// any levels skipped between a node and its child are free variables.
+			ret = (this->countBelow(lo) << (this->level(lo) - lv - 1))
+				+ (this->countBelow(hi) << (this->level(hi) - lv - 1));
+		}
+
+		return (this->counts[n] = ret);
+	}
+
+	BigNum Bdd::satCount(Node f)
+	{
+		return this->countBelow(f) << this->level(f);
+	}
+
+	void Bdd::solution(Node f, uint64_t index, Assignment& out)
+	{
+		if(out.size() != this->nvars)
+			out = Assignment(this->nvars);
+
+		auto node = f;
+		for(uint32_t lv = 0; lv < this->nvars; lv++)
+		{
+			// if the node is below this level, the variable is a don't-care, and both halves
+			// have the same number of solutions.
+			bool skipped = this->level(node) != lv;
+
+			auto lo = skipped ? node : this->nodes[node].lo;
+			auto low_count = this->countBelow(lo) << (this->level(lo) - lv - 1);
+
+			if(!low_count.fitsU64() || index < low_count.u64())
+			{
+				out.set(lv, false);
+				node = lo;
+			}
+			else
+			{
+				index -= low_count.u64();
+				out.set(lv, true);
+				node = skipped ? node : this->nodes[node].hi;
+			}
+		}
+	}
+
+	void Bdd::randomSolution(Node f, std::mt19937_64& rng, Assignment& out)
+	{
+		if(out.size() != this->nvars)
+			out = Assignment(this->nvars);
+
+		auto node = f;
+		for(uint32_t lv = 0; lv < this->nvars; lv++)
+		{
+			// a don't-care goes either way with the same number of solutions.
+			if(this->level(node) != lv)
+			{
+				out.set(lv, rng() & 1);
+				continue;
+			}
+
+			auto lo = this->nodes[node].lo;
+			auto hi = this->nodes[node].hi;
+
+			// each side is taken in proportion to its solutions. the counts only get too big for a
+			// double past 1000-odd variables, at which point a coin flip is the best we can do.
+			auto n_lo = std::ldexp(this->countBelow(lo).f64(), (int) (this->level(lo) - lv - 1));
+			auto n_hi = std::ldexp(this->countBelow(hi).f64(), (int) (this->level(hi) - lv - 1));
+
+			double p_hi = 0.5;
+			if(lo == FALSE)         p_hi = 1;
+			else if(hi == FALSE)    p_hi = 0;
+			else if(std::isfinite(n_lo + n_hi))
+				p_hi = n_hi / (n_lo + n_hi);
+
+			bool value = std::uniform_real_distribution<double>(0, 1)(rng) < p_hi;
+			out.set(lv, value);
+			node = value ? hi : lo;
+		}
+	}
+
+
+
+	// covers `lower` with cubes inside `upper`; the top variable only stays in cubes that need it.
+	Bdd::Node Bdd::isop(Node lower, Node upper, PartialAssignment& cube, std::vector<PartialAssignment>* out,
+		size_t max_cubes)
+	{
+		if(lower == FALSE || this->failed || out->size() >= max_cubes)
+			return FALSE;
+
+		if(upper == TRUE)
+		{
+			out->push_back(cube);
+			return TRUE;
+		}
+
+		auto top = std::min(this->level(lower), this->level(upper));
+		auto cofactor = [this, top](Node n, bool high) -> Node {
+			if(this->level(n) != top)
+				return n;
+
+			return high ? this->nodes[n].hi : this->nodes[n].lo;
+		};
+
+		auto l0 = cofactor(lower, false);   auto l1 = cofactor(lower, true);
+		auto u0 = cofactor(upper, false);   auto u1 = cofactor(upper, true);
+
+		cube.set(top, false);
+		auto r0 = this->isop(this->bddAnd(l0, this->bddNot(u1)), u0, cube, out, max_cubes);
+
+		cube.set(top, true);
+		auto r1 = this->isop(this->bddAnd(l1, this->bddNot(u0)), u1, cube, out, max_cubes);
+
+		cube.unset(top);
+		auto rest = this->ite(this->bddAnd(l0, this->bddNot(r0)), TRUE, this->bddAnd(l1, this->bddNot(r1)));
+		auto r = this->isop(rest, this->bddAnd(u0, u1), cube, out, max_cubes);
+
+		return this->ite(r, TRUE, this->mk(top, r0, r1));
+	}
+
+	bool Bdd::cover(Node f, std::vector<PartialAssignment>* out, size_t max_cubes)
+	{
+		// nothing gets collected in here, so the intermediate results don't need to be referenced.
+		auto cube = PartialAssignment(this->nvars);
+		this->isop(f, f, cube, out, max_cubes);
+
+		return !this->failed;
+	}
+}
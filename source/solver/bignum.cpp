@@ -0,0 +1,180 @@
+// bignum.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "solver.h"
+
+namespace solver
+{
+	BigNum::BigNum(uint64_t x)
+	{
+		this->limbs.push_back((uint32_t) x);
+		this->limbs.push_back((uint32_t) (x >> 32));
+		this->trim();
+	}
+
+	void BigNum::trim()
+	{
+		while(!this->limbs.empty() && this->limbs.back() == 0)
+			this->limbs.pop_back();
+	}
+
+	BigNum BigNum::operator+ (const BigNum& other) const
+	{
+		auto ret = BigNum();
+		auto n = std::max(this->limbs.size(), other.limbs.size());
+
+		uint64_t carry = 0;
+		for(size_t i = 0; i < n; i++)
+		{
+			uint64_t a = i < this->limbs.size() ? this->limbs[i] : 0;
+			uint64_t b = i < other.limbs.size() ? other.limbs[i] : 0;
+
+			auto sum = a + b + carry;
+			ret.limbs.push_back((uint32_t) sum);
+			carry = sum >> 32;
+		}
+
+		if(carry)
+			ret.limbs.push_back((uint32_t) carry);
+
+		return ret;
+	}
+
+	BigNum BigNum::operator- (const BigNum& other) const
+	{
+		if(*this < other)
+			lg::fatal("solver", "bignum subtraction underflowed");
+
+		auto ret = *this;
+
+		int64_t borrow = 0;
+		for(size_t i = 0; i < ret.limbs.size(); i++)
+		{
+			int64_t b = i < other.limbs.size() ? other.limbs[i] : 0;
+			auto diff = (int64_t) ret.limbs[i] - b - borrow;
+
+			borrow = diff < 0 ? 1 : 0;
+			ret.limbs[i] = (uint32_t) (diff + (borrow << 32));
+		}
+
+		ret.trim();
+		return ret;
+	}
+
+	BigNum BigNum::operator* (const BigNum& other) const
+	{
+		if(this->isZero() || other.isZero())
+			return BigNum();
+
+		// the numbers here are small enough that schoolbook multiplication is fine.
+		auto ret = BigNum();
+		ret.limbs.resize(this->limbs.size() + other.limbs.size(), 0);
+
+		for(size_t i = 0; i < this->limbs.size(); i++)
+		{
+			uint64_t carry = 0;
+			for(size_t k = 0; k < other.limbs.size(); k++)
+			{
+				auto cur = (uint64_t) this->limbs[i] * other.limbs[k] + ret.limbs[i + k] + carry;
+				ret.limbs[i + k] = (uint32_t) cur;
+				carry = cur >> 32;
+			}
+
+			ret.limbs[i + other.limbs.size()] = (uint32_t) carry;
+		}
+
+		ret.trim();
+		return ret;
+	}
+
+	BigNum BigNum::operator<< (size_t shift) const
+	{
+		if(this->isZero())
+			return *this;
+
+		auto ret = BigNum();
+		ret.limbs.resize(shift / 32, 0);
+
+		auto bits = shift % 32;
+		uint32_t carry = 0;
+		for(auto l : this->limbs)
+		{
+			ret.limbs.push_back((l << bits) | carry);
+			carry = bits == 0 ? 0 : (l >> (32 - bits));
+		}
+
+		if(carry)
+			ret.limbs.push_back(carry);
+
+		return ret;
+	}
+
+	bool BigNum::operator< (const BigNum& other) const
+	{
+		if(this->limbs.size() != other.limbs.size())
+			return this->limbs.size() < other.limbs.size();
+
+		for(size_t i = this->limbs.size(); i > 0; i--)
+		{
+			if(this->limbs[i - 1] != other.limbs[i - 1])
+				return this->limbs[i - 1] < other.limbs[i - 1];
+		}
+
+		return false;
+	}
+
+	uint64_t BigNum::u64() const
+	{
+		uint64_t ret = 0;
+		if(this->limbs.size() > 0) ret |= this->limbs[0];
+		if(this->limbs.size() > 1) ret |= (uint64_t) this->limbs[1] << 32;
+
+		return ret;
+	}
+
+	double BigNum::f64() const
+	{
+		double ret = 0;
+		for(size_t i = this->limbs.size(); i > 0; i--)
+			ret = ret * 4294967296.0 + this->limbs[i - 1];
+
+		return ret;
+	}
+
+	std::string BigNum::str() const
+	{
+		if(this->isZero())
+			return "0";
+
+		// repeatedly divide by 10^9, collecting the remainders.
+		auto digits = std::string();
+		auto num = this->limbs;
+
+		while(!num.empty())
+		{
+			uint64_t rem = 0;
+			for(size_t i = num.size(); i > 0; i--)
+			{
+				auto cur = (rem << 32) | num[i - 1];
+				num[i - 1] = (uint32_t) (cur / 1'000'000'000);
+				rem = cur % 1'000'000'000;
+			}
+
+			while(!num.empty() && num.back() == 0)
+				num.pop_back();
+
+			for(int k = 0; k < 9; k++)
+			{
+				digits += (char) ('0' + rem % 10);
+				rem /= 10;
+
+				if(num.empty() && rem == 0)
+					break;
+			}
+		}
+
+		std::reverse(digits.begin(), digits.end());
+		return digits;
+	}
+}
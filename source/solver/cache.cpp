@@ -0,0 +1,75 @@
+// cache.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "solver.h"
+
+namespace solver
+{
+	ResultCache::~ResultCache()
+	{
+		for(auto& slot : this->slots)
+			delete slot.entry.cursor;
+	}
+
+	void ResultCache::put(const std::string& key, Entry entry)
+	{
+		if(auto it = this->index.find(key); it != this->index.end())
+		{
+			this->used -= it->second->bytes;
+			delete it->second->entry.cursor;
+
+			this->slots.erase(it->second);
+			this->index.erase(it);
+		}
+
+		// the key is there twice, in the slot and in the index.
+		auto bytes = sizeof(Slot) + 2 * key.size() + (entry.cursor ? entry.cursor->memoryUsage() : 0);
+
+		// don't bother throwing everything else out for something that wouldn't fit anyway.
+		if(bytes > this->maxBytes)
+		{
+			delete entry.cursor;
+			return;
+		}
+
+		this->slots.push_front(Slot { key, std::move(entry), bytes });
+		this->index[key] = this->slots.begin();
+		this->used += bytes;
+
+		this->evict();
+	}
+
+	bool ResultCache::take(const std::string& key, Entry* out)
+	{
+		auto it = this->index.find(key);
+		if(it == this->index.end())
+			return false;
+
+		*out = std::move(it->second->entry);
+		this->used -= it->second->bytes;
+
+		this->slots.erase(it->second);
+		this->index.erase(it);
+		return true;
+	}
+
+	void ResultCache::setLimit(size_t max_bytes)
+	{
+		this->maxBytes = max_bytes;
+		this->evict();
+	}
+
+	void ResultCache::evict()
+	{
+		while(this->used > this->maxBytes && !this->slots.empty())
+		{
+			auto& slot = this->slots.back();
+			this->used -= slot.bytes;
+			delete slot.entry.cursor;
+
+			this->index.erase(slot.key);
+			this->slots.pop_back();
+		}
+	}
+}
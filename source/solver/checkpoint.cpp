@@ -0,0 +1,118 @@
+// checkpoint.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <cstdio>
+
+#include "solver.h"
+
+namespace solver
+{
+	// "alphachk", and which version of the layout this is.
+	static constexpr uint64_t SAVED_SEARCH_MAGIC    = 0x6b68'6361'6870'6c61;
+	static constexpr uint64_t SAVED_SEARCH_VERSION  = 3;
+
+	// 64-bit words in native byte order: magic, version, key length, engine, number of variables, the
+	// checkpoint (4), number of parts, the pins, then 5 per part; the key's bytes come last.
+	static constexpr size_t HEADER_WORDS = 10;
+	static constexpr size_t PART_WORDS = 5;
+
+	// nothing with anywhere near this many variables could have been brute-forced, so the file is broken.
+	static constexpr uint64_t MAX_SAVED_VARS = 1 << 16;
+	static constexpr uint64_t MAX_KEY_LENGTH = 1 << 26;
+
+	bool writeSavedSearch(const std::string& path, const SavedSearch& search)
+	{
+		auto& cp = search.cursor;
+		auto words = std::vector<uint64_t>({
+			SAVED_SEARCH_MAGIC, SAVED_SEARCH_VERSION,
+			search.key.size(), search.engine, search.pins.size(),
+			cp.hasCurrent, cp.position, cp.row, cp.scanned,
+			cp.parts.size()
+		});
+
+		words.insert(words.end(), search.pins.values.words.begin(), search.pins.values.words.end());
+		words.insert(words.end(), search.pins.assigned.words.begin(), search.pins.assigned.words.end());
+
+		for(size_t i = 0; i < cp.parts.size(); i++)
+		{
+			auto& p = cp.parts[i];
+			words.insert(words.end(), { (uint64_t) cp.reversed[i], p.hasCurrent, p.position, p.row, p.scanned });
+		}
+
+		auto tmp = path + ".tmp";
+		auto f = std::fopen(tmp.c_str(), "wb");
+		if(f == nullptr)
+			return false;
+
+		bool ok = (std::fwrite(words.data(), sizeof(uint64_t), words.size(), f) == words.size())
+			&& (std::fwrite(search.key.data(), 1, search.key.size(), f) == search.key.size());
+
+		ok = (std::fclose(f) == 0) && ok;
+
+		if(!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+		{
+			std::remove(tmp.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool readSavedSearch(const std::string& path, SavedSearch* out)
+	{
+		auto f = std::fopen(path.c_str(), "rb");
+		if(f == nullptr)
+			return false;
+
+		uint64_t header[HEADER_WORDS];
+		if(std::fread(header, sizeof(uint64_t), HEADER_WORDS, f) != HEADER_WORDS
+			|| header[0] != SAVED_SEARCH_MAGIC || header[1] != SAVED_SEARCH_VERSION || header[4] > MAX_SAVED_VARS
+			|| header[9] > header[4] || header[2] > MAX_KEY_LENGTH)
+		{
+			std::fclose(f);
+			return false;
+		}
+
+		auto ret = SavedSearch();
+		ret.key = std::string(header[2], '\0');
+		ret.engine = (uint32_t) header[3];
+		ret.pins = PartialAssignment(header[4]);
+		ret.cursor.hasCurrent = (header[5] != 0);
+		ret.cursor.position = header[6];
+		ret.cursor.row = header[7];
+		ret.cursor.scanned = header[8];
+
+		auto& values = ret.pins.values.words;
+		auto& assigned = ret.pins.assigned.words;
+
+		// every part has at least one variable, so there can't be more of them than that.
+		auto parts = std::vector<uint64_t>(PART_WORDS * header[9]);
+
+		bool ok = std::fread(values.data(), sizeof(uint64_t), values.size(), f) == values.size()
+			&& std::fread(assigned.data(), sizeof(uint64_t), assigned.size(), f) == assigned.size()
+			&& std::fread(parts.data(), sizeof(uint64_t), parts.size(), f) == parts.size()
+			&& std::fread(ret.key.data(), 1, ret.key.size(), f) == ret.key.size();
+
+		std::fclose(f);
+		if(!ok)
+			return false;
+
+		for(size_t i = 0; i < header[9]; i++)
+		{
+			auto w = &parts[PART_WORDS * i];
+
+			auto p = Cursor::Checkpoint();
+			p.hasCurrent = (w[1] != 0);
+			p.position = w[2];
+			p.row = w[3];
+			p.scanned = w[4];
+
+			ret.cursor.reversed.push_back(w[0] != 0);
+			ret.cursor.parts.push_back(std::move(p));
+		}
+
+		*out = std::move(ret);
+		return true;
+	}
+}
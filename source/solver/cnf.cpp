@@ -0,0 +1,88 @@
+// cnf.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	namespace
+	{
+		struct Encoder
+		{
+			Sat& sat;
+			std::unordered_map<std::string, uint32_t> indices;
+
+			// a variable that is forced true, for encoding constants; made on demand.
+			Lit constTrue = UINT32_MAX;
+
+			Encoder(Sat& s) : sat(s) { }
+		};
+	}
+
+	static Lit encode(Encoder& enc, const ast::Expr* expr)
+	{
+		if(auto l = dynamic_cast<const ast::Lit*>(expr); l != nullptr)
+		{
+			if(enc.constTrue == UINT32_MAX)
+			{
+				enc.constTrue = mkLit(enc.sat.newVar());
+				enc.sat.addClause({ enc.constTrue });
+			}
+
+			return l->value ? enc.constTrue : negate(enc.constTrue);
+		}
+		else if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			auto it = enc.indices.find(v->name);
+			if(it == enc.indices.end())
+				lg::fatal("solver", "variable '{}' missing from the variable list", v->name);
+
+			return mkLit(it->second);
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			return negate(encode(enc, n->e));
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			auto conjuncts = std::vector<const ast::Expr*>();
+			// each chain only needs one gate variable.
+			flattenAnd(a, conjuncts);
+
+			auto lits = std::vector<Lit>();
+			for(auto c : conjuncts)
+				lits.push_back(encode(enc, c));
+
+			// g <-> (a1 & a2 & ... & an)
+			auto g = mkLit(enc.sat.newVar());
+
+			auto big = std::vector<Lit>({ g });
+			for(auto l : lits)
+			{
+				enc.sat.addClause({ negate(g), l });
+				big.push_back(negate(l));
+			}
+
+			enc.sat.addClause(std::move(big));
+			return g;
+		}
+		else
+		{
+			lg::fatal("solver", "invalid expression");
+		}
+	}
+
+	Lit encodeTseitin(Sat& sat, const ast::Expr* expr, const std::vector<std::string>& vars)
+	{
+		while(sat.numVars() < vars.size())
+			sat.newVar();
+
+		auto enc = Encoder(sat);
+		for(size_t i = 0; i < vars.size(); i++)
+			enc.indices[vars[i]] = (uint32_t) i;
+
+		return encode(enc, expr);
+	}
+}
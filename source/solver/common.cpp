@@ -0,0 +1,63 @@
+// common.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	void flattenAnd(const ast::Expr* expr, std::vector<const ast::Expr*>& out)
+	{
+		if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			flattenAnd(a->left, out);
+			flattenAnd(a->right, out);
+		}
+		else
+		{
+			out.push_back(expr);
+		}
+	}
+
+	static void first_appearance(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices,
+		std::vector<bool>& seen, std::vector<uint32_t>& order)
+	{
+		if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			if(auto it = indices.find(v->name); it != indices.end() && !seen[it->second])
+			{
+				seen[it->second] = true;
+				order.push_back(it->second);
+			}
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			first_appearance(n->e, indices, seen, order);
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			first_appearance(a->left, indices, seen, order);
+			first_appearance(a->right, indices, seen, order);
+		}
+	}
+
+	std::vector<uint32_t> firstAppearanceOrder(const ast::Expr* expr, const std::vector<std::string>& vars, bool everything)
+	{
+		auto indices = std::unordered_map<std::string, uint32_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = (uint32_t) i;
+
+		auto seen = std::vector<bool>(vars.size(), false);
+		auto order = std::vector<uint32_t>();
+		first_appearance(expr, indices, seen, order);
+
+		for(uint32_t i = 0; everything && i < vars.size(); i++)
+		{
+			if(!seen[i])
+				order.push_back(i);
+		}
+
+		return order;
+	}
+}
@@ -0,0 +1,334 @@
+// count.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	namespace
+	{
+		// hash-consed, so the same subexpression is always the same node and only gets counted once.
+		struct Counter
+		{
+			static constexpr uint8_t KIND_CONST = 0;    // a: 0 or 1
+			static constexpr uint8_t KIND_VAR   = 1;    // a: variable index
+			static constexpr uint8_t KIND_NOT   = 2;    // a: operand
+			static constexpr uint8_t KIND_AND   = 3;    // a, b: operands
+
+			static constexpr uint32_t FALSE = 0;
+			static constexpr uint32_t TRUE  = 1;
+
+			struct Node
+			{
+				uint8_t kind;
+				uint32_t a;
+				uint32_t b;
+			};
+
+			std::vector<Node> nodes;
+			std::vector<std::vector<uint32_t>> supports;    // the variables under each node, sorted
+			std::unordered_map<uint64_t, uint32_t> unique;
+			std::unordered_map<uint32_t, BigNum> cache;
+
+			const std::function<bool ()>& interrupt;
+			size_t maxNodes;
+			size_t steps = 0;
+			bool failed = false;
+
+			Counter(const std::function<bool ()>& interrupt, size_t max_nodes) : interrupt(interrupt), maxNodes(max_nodes)
+			{
+				this->nodes.push_back({ KIND_CONST, 0, 0 });
+				this->nodes.push_back({ KIND_CONST, 1, 0 });
+				this->supports.resize(2);
+			}
+
+			uint32_t mk(uint8_t kind, uint32_t a, uint32_t b);
+			uint32_t mkNot(uint32_t a);
+			uint32_t mkAnd(uint32_t a, uint32_t b);
+
+			uint32_t convert(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices);
+			uint32_t restrict(uint32_t f, uint32_t var, bool value, std::unordered_map<uint32_t, uint32_t>& memo);
+			BigNum count(uint32_t f);
+
+			size_t width(uint32_t f) const { return this->supports[f].size(); }
+		};
+	}
+
+	uint32_t Counter::mk(uint8_t kind, uint32_t a, uint32_t b)
+	{
+		auto key = ((uint64_t) kind << 62) | ((uint64_t) a << 31) | b;
+		if(auto it = this->unique.find(key); it != this->unique.end())
+			return it->second;
+
+		if(this->nodes.size() >= this->maxNodes)
+		{
+			this->failed = true;
+			return FALSE;
+		}
+
+		auto support = std::vector<uint32_t>();
+		if(kind == KIND_VAR)
+		{
+			support.push_back(a);
+		}
+		else if(kind == KIND_NOT)
+		{
+			support = this->supports[a];
+		}
+		else
+		{
+			auto& l = this->supports[a];
+			auto& r = this->supports[b];
+			std::set_union(l.begin(), l.end(), r.begin(), r.end(), std::back_inserter(support));
+		}
+
+		auto idx = (uint32_t) this->nodes.size();
+		this->nodes.push_back({ kind, a, b });
+		this->supports.push_back(std::move(support));
+
+		this->unique[key] = idx;
+		return idx;
+	}
+
+	uint32_t Counter::mkNot(uint32_t a)
+	{
+		if(a == FALSE)  return TRUE;
+		if(a == TRUE)   return FALSE;
+
+		if(this->nodes[a].kind == KIND_NOT)
+			return this->nodes[a].a;
+
+		return this->mk(KIND_NOT, a, 0);
+	}
+
+	uint32_t Counter::mkAnd(uint32_t a, uint32_t b)
+	{
+		if(a == FALSE || b == FALSE)
+			return FALSE;
+
+		if(a == TRUE)   return b;
+		if(b == TRUE)   return a;
+		if(a == b)      return a;
+
+		// x & !x
+		if((this->nodes[a].kind == KIND_NOT && this->nodes[a].a == b)
+			|| (this->nodes[b].kind == KIND_NOT && this->nodes[b].a == a))
+			return FALSE;
+
+		return this->mk(KIND_AND, std::min(a, b), std::max(a, b));
+	}
+
+	uint32_t Counter::convert(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices)
+	{
+		if(auto l = dynamic_cast<const ast::Lit*>(expr); l != nullptr)
+		{
+			return l->value ? TRUE : FALSE;
+		}
+		else if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			auto it = indices.find(v->name);
+			if(it == indices.end())
+				lg::fatal("solver", "variable '{}' missing from the variable list", v->name);
+
+			return this->mk(KIND_VAR, it->second, 0);
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			return this->mkNot(this->convert(n->e, indices));
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			auto l = this->convert(a->left, indices);
+			return this->mkAnd(l, this->convert(a->right, indices));
+		}
+		else
+		{
+			lg::fatal("solver", "invalid expression");
+		}
+	}
+
+	uint32_t Counter::restrict(uint32_t f, uint32_t var, bool value, std::unordered_map<uint32_t, uint32_t>& memo)
+	{
+		auto& support = this->supports[f];
+		if(!std::binary_search(support.begin(), support.end(), var))
+			return f;
+
+		if(auto it = memo.find(f); it != memo.end())
+			return it->second;
+
+		// mk() can move the node array around, so copy this out first.
+		auto node = this->nodes[f];
+
+		uint32_t ret = FALSE;
+		if(node.kind == KIND_VAR)
+		{
+			ret = value ? TRUE : FALSE;
+		}
+		else if(node.kind == KIND_NOT)
+		{
+			ret = this->mkNot(this->restrict(node.a, var, value, memo));
+		}
+		else if(auto l = this->restrict(node.a, var, value, memo); l != FALSE)
+		{
+			ret = this->mkAnd(l, this->restrict(node.b, var, value, memo));
+		}
+
+		return (memo[f] = ret);
+	}
+
+	// the number of satisfying assignments of the variables in f's support.
+	BigNum Counter::count(uint32_t f)
+	{
+		if(this->failed)
+			return BigNum();
+
+		if((++this->steps % 4096) == 0 && this->interrupt && this->interrupt())
+		{
+			this->failed = true;
+			return BigNum();
+		}
+
+		if(f == FALSE)  return BigNum(0);
+		if(f == TRUE)   return BigNum(1);
+
+		if(auto it = this->cache.find(f); it != this->cache.end())
+			return it->second;
+
+		auto node = this->nodes[f];
+
+		BigNum ret;
+		if(node.kind == KIND_VAR)
+		{
+			ret = BigNum(1);
+		}
+		else if(node.kind == KIND_NOT)
+		{
+			ret = (BigNum(1) << this->width(node.a)) - this->count(node.a);
+		}
+		else
+		{
+			auto conjuncts = std::vector<uint32_t>();
+			auto stack = std::vector<uint32_t>({ f });
+			while(!stack.empty())
+			{
+				auto n = stack.back();
+				stack.pop_back();
+
+				if(this->nodes[n].kind == KIND_AND)
+				{
+					stack.push_back(this->nodes[n].a);
+					stack.push_back(this->nodes[n].b);
+				}
+				else
+				{
+					conjuncts.push_back(n);
+				}
+			}
+
+			// conjuncts that share a variable (even indirectly) go in the same component.
+			auto parent = std::unordered_map<uint32_t, uint32_t>();
+			auto find = [&parent](uint32_t v) -> uint32_t {
+				while(parent[v] != v)
+					v = parent[v] = parent[parent[v]];
+				return v;
+			};
+
+			for(auto c : conjuncts)
+			{
+				auto& support = this->supports[c];
+				for(auto v : support)
+					parent.emplace(v, v);
+
+				for(size_t i = 1; i < support.size(); i++)
+					parent[find(support[i])] = find(support[0]);
+			}
+
+			auto components = std::unordered_map<uint32_t, uint32_t>();
+			for(auto c : conjuncts)
+			{
+				auto root = find(this->supports[c][0]);
+				if(auto it = components.find(root); it != components.end())
+					it->second = this->mkAnd(it->second, c);
+				else
+					components[root] = c;
+			}
+
+			if(components.size() > 1)
+			{
+				ret = BigNum(1);
+				for(auto& [ _, comp ] : components)
+				{
+					ret *= this->count(comp);
+					if(ret.isZero())
+						break;
+				}
+			}
+			else
+			{
+				// a lone (possibly negated) variable decides itself, so take those first; otherwise
+				// split on the variable that's in the most conjuncts.
+				uint32_t split = UINT32_MAX;
+				auto occurrences = std::unordered_map<uint32_t, size_t>();
+				for(auto c : conjuncts)
+				{
+					auto& nd = this->nodes[c];
+					if(nd.kind == KIND_VAR || (nd.kind == KIND_NOT && this->nodes[nd.a].kind == KIND_VAR))
+					{
+						split = this->supports[c][0];
+						break;
+					}
+
+					for(auto v : this->supports[c])
+						occurrences[v] += 1;
+				}
+
+				if(split == UINT32_MAX)
+				{
+					size_t best = 0;
+					for(auto [ v, k ] : occurrences)
+					{
+						if(k > best || (k == best && v < split))
+							best = k, split = v;
+					}
+				}
+
+				auto memo = std::unordered_map<uint32_t, uint32_t>();
+				auto lo = this->restrict(f, split, false, memo);
+
+				memo.clear();
+				auto hi = this->restrict(f, split, true, memo);
+
+				// variables that disappear along with the split variable are free in that half.
+				auto n = this->width(f);
+				ret = (this->count(lo) << (n - 1 - this->width(lo)))
+					+ (this->count(hi) << (n - 1 - this->width(hi)));
+			}
+		}
+
+		if(this->failed)
+			return BigNum();
+
+		return (this->cache[f] = ret);
+	}
+
+	bool countModels(const ast::Expr* expr, const std::vector<std::string>& vars, BigNum* out,
+		const std::function<bool ()>& interrupt, size_t max_nodes)
+	{
+		auto indices = std::unordered_map<std::string, uint32_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = (uint32_t) i;
+
+		auto counter = Counter(interrupt, max_nodes);
+		auto root = counter.convert(expr, indices);
+
+		auto ret = counter.count(root);
+		if(counter.failed)
+			return false;
+
+		// variables that aren't in the expression at all can be anything.
+		*out = ret << (vars.size() - counter.width(root));
+		return true;
+	}
+}
@@ -0,0 +1,68 @@
+// cover.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	bool satCover(const ast::Expr* expr, const std::vector<std::string>& vars, std::vector<PartialAssignment>* out,
+		size_t max_cubes, const std::function<bool ()>& interrupt)
+	{
+		// `on` finds solutions that aren't covered yet, and `off` finds non-solutions inside a cube.
+		auto on = Sat();
+		auto off = Sat();
+		on.interrupt = interrupt;
+		off.interrupt = interrupt;
+
+		on.addClause({ encodeTseitin(on, expr, vars) });
+		off.addClause({ negate(encodeTseitin(off, expr, vars)) });
+
+		while(out->size() < max_cubes)
+		{
+			auto result = on.solve();
+			if(result == Sat::RESULT_UNKNOWN)
+				return false;
+
+			if(result == Sat::RESULT_UNSAT)
+				break;
+
+			auto lits = std::vector<Lit>();
+			for(size_t i = 0; i < vars.size(); i++)
+				lits.push_back(mkLit((uint32_t) i, /* neg: */ !on.modelValue((uint32_t) i)));
+
+			// a literal can go if the cube without it still has no non-solutions in it.
+			for(size_t i = 0; i < lits.size(); )
+			{
+				auto without = lits;
+				without.erase(without.begin() + (ptrdiff_t) i);
+
+				auto r = off.solve(without);
+				if(r == Sat::RESULT_UNKNOWN)
+					return false;
+
+				if(r == Sat::RESULT_UNSAT)
+					lits = std::move(without);
+				else
+					i++;
+			}
+
+			auto cube = PartialAssignment(vars.size());
+			for(auto l : lits)
+				cube.set(litVar(l), !litNeg(l));
+
+			out->push_back(std::move(cube));
+
+			// the next solution has to be outside this cube; if the cube is everything, we're done.
+			auto block = std::vector<Lit>();
+			for(auto l : lits)
+				block.push_back(negate(l));
+
+			if(!on.addClause(std::move(block)))
+				break;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,920 @@
+// cursor.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <atomic>
+#include <algorithm>
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	// how many blocks (of 64 assignments) to scan between checking for aborts; this is
+	// also the unit of work that gets handed out to threads.
+	static constexpr uint64_t BLOCKS_PER_CHUNK  = 1024;
+
+	// how many chunks each worker gets per round of a search. searches stop at the end of the
+	// first round that found something, so this bounds the wasted work past the solution.
+	static constexpr uint64_t CHUNKS_PER_WORKER = 8;
+
+	// how many assignments the gray code cursor goes through between checking for aborts.
+	static constexpr uint64_t GRAY_STEPS_PER_POLL = 1 << 16;
+
+	int Cursor::next()
+	{
+		if(!this->hasNext())
+			return STEP_END;
+
+		auto ret = this->forward();
+		if(ret == STEP_FOUND)
+		{
+			this->position = this->hasCurrent ? this->position + 1 : 0;
+			this->hasCurrent = true;
+		}
+		else if(ret == STEP_END)
+		{
+			this->exhausted = true;
+			this->total = this->hasCurrent ? this->position + 1 : 0;
+		}
+
+		return ret;
+	}
+
+	int Cursor::prev()
+	{
+		if(!this->hasPrev())
+			return STEP_END;
+
+		auto ret = this->backward();
+		if(ret == STEP_FOUND)
+			this->position -= 1;
+
+		return ret;
+	}
+
+	bool Cursor::hasNext() const
+	{
+		auto n = BigNum();
+		if(!this->count(&n))
+			return true;
+
+		return BigNum(this->hasCurrent ? this->position + 1 : 0) < n;
+	}
+
+	bool Cursor::count(BigNum* out) const
+	{
+		if(!this->exhausted)
+			return false;
+
+		*out = BigNum(this->total);
+		return true;
+	}
+
+	bool Cursor::save(Checkpoint* out) const
+	{
+		*out = Checkpoint();
+		out->hasCurrent = this->hasCurrent;
+		out->position = this->position;
+
+		return this->saveFrontier(out);
+	}
+
+	bool Cursor::resume(const Checkpoint& cp)
+	{
+		if(!this->loadFrontier(cp))
+			return false;
+
+		this->hasCurrent = cp.hasCurrent;
+		this->position = cp.position;
+		return true;
+	}
+
+
+
+	namespace
+	{
+		struct BruteForceCursor : Cursor
+		{
+			Tape tape;
+			size_t workers = 1;
+			uint64_t row = 0;
+
+			// how many rows after this one (or from the start) an interrupted search already went through.
+			uint64_t scanned = 0;
+
+			// if there's a pool, the scanning happens there instead of on our threads.
+			std::shared_ptr<WorkerPool> pool;
+			uint64_t tapeId = 0;
+
+			BruteForceCursor(Tape t, size_t num_workers) : tape(std::move(t)), workers(num_workers)
+			{
+				this->current = Assignment(this->tape.numVars);
+			}
+
+			BruteForceCursor(Tape t, std::shared_ptr<WorkerPool> p) : tape(std::move(t)), workers(p->size()),
+				pool(std::move(p)), tapeId(this->pool->newTapeId())
+			{
+				this->current = Assignment(this->tape.numVars);
+			}
+
+			virtual size_t memoryUsage() const override
+			{
+				return sizeof(*this) + this->tape.ops.size() * sizeof(Tape::Op);
+			}
+
+			virtual int forward() override;
+			virtual int backward() override;
+
+			virtual bool saveFrontier(Checkpoint* out) const override;
+			virtual bool loadFrontier(const Checkpoint& cp) override;
+
+			int search(uint64_t start, bool fwd);
+			bool scanRound(uint64_t first, uint64_t first_mask, bool fwd, uint64_t blocks, uint64_t round,
+				uint64_t tasks, std::atomic<uint64_t>& best, std::atomic<uint64_t>& scanned);
+		};
+
+		struct GrayCodeCursor : Cursor
+		{
+			Evaluator eval;
+			size_t nvars = 0;
+
+			// the evaluator is at assignment gray(counter), and the current solution is gray(row).
+			uint64_t counter = 0;
+			uint64_t row = 0;
+
+			// how many steps after this one (or from the start) an interrupted walk already went through.
+			uint64_t scanned = 0;
+
+			GrayCodeCursor(const ast::Expr* expr, const std::vector<std::string>& vars) : eval(expr, vars),
+				nvars(vars.size())
+			{
+				// gray(0) is all zeroes.
+				for(size_t k = 0; k < this->nvars; k++)
+					this->eval.set((uint32_t) k, false);
+
+				this->current = Assignment(this->nvars);
+			}
+
+			virtual int forward() override;
+			virtual int backward() override;
+			virtual size_t memoryUsage() const override { return sizeof(*this) + this->eval.memoryUsage(); }
+
+			virtual bool saveFrontier(Checkpoint* out) const override;
+			virtual bool loadFrontier(const Checkpoint& cp) override;
+
+			int walk(bool fwd);
+			void seek(uint64_t target);
+		};
+
+		struct SatCursor : Cursor
+		{
+			Sat sat;
+			bool unsat = false;
+
+			// pinned variables are assumed for every call, and only the free ones need blocking.
+			std::vector<Lit> assumptions;
+			std::vector<uint32_t> freeVars;
+
+			// the sat solver can only go forwards.
+			RecentSolutions recent;
+
+			SatCursor(size_t num_vars) { this->current = Assignment(num_vars); }
+
+			virtual bool hasPrev() const override
+			{
+				return Cursor::hasPrev() && this->recent.has(this->position - 1);
+			}
+
+			virtual size_t memoryUsage() const override
+			{
+				return sizeof(*this) + this->sat.memoryUsage() + RecentSolutions::memoryUsage(this->current.size());
+			}
+
+			virtual int forward() override;
+			virtual int backward() override;
+		};
+
+		struct PinnedCursor : Cursor
+		{
+			Cursor* inner = nullptr;
+			std::vector<uint32_t> freeVars;
+
+			PinnedCursor(Cursor* c, const PartialAssignment& pins) : inner(c)
+			{
+				// the pinned values never change, so they can go in once.
+				this->current = pins.values;
+				for(size_t k = 0; k < pins.size(); k++)
+				{
+					if(!pins.isAssigned(k))
+						this->freeVars.push_back((uint32_t) k);
+				}
+
+				this->inner->interrupt = [this]() -> bool {
+					return this->interrupt && this->interrupt();
+				};
+
+				this->inner->progress = [this](uint64_t done, uint64_t total) {
+					if(this->progress)
+						this->progress(done, total);
+				};
+
+				this->inner->onFrontier = [this]() {
+					if(this->onFrontier)
+						this->onFrontier();
+				};
+			}
+
+			virtual ~PinnedCursor() override { delete this->inner; }
+
+			virtual int forward() override { return this->fill(this->inner->next()); }
+			virtual int backward() override { return this->fill(this->inner->prev()); }
+			virtual bool count(BigNum* out) const override { return this->inner->count(out); }
+			virtual bool hasPrev() const override { return this->inner->hasPrev(); }
+
+			// the inner cursor is always at the same place as this one.
+			virtual bool saveFrontier(Checkpoint* out) const override { return this->inner->save(out); }
+			virtual bool loadFrontier(const Checkpoint& cp) override
+			{
+				if(!this->inner->resume(cp))
+					return false;
+
+				if(cp.hasCurrent)
+					this->fill(STEP_FOUND);
+
+				return true;
+			}
+
+			virtual size_t memoryUsage() const override
+			{
+				return sizeof(*this) + this->inner->memoryUsage();
+			}
+
+			int fill(int result)
+			{
+				if(result == STEP_FOUND)
+				{
+					auto& values = this->inner->values();
+					for(size_t k = 0; k < this->freeVars.size(); k++)
+						this->current.set(this->freeVars[k], values.get(k));
+				}
+
+				return result;
+			}
+		};
+
+		// an odometer where each part turns around instead of winding back, so a step only moves one part.
+		struct ProductCursor : Cursor
+		{
+			std::vector<Cursor*> parts;
+			std::vector<std::vector<uint32_t>> indices;
+			std::vector<bool> reversed;
+
+			ProductCursor(std::vector<Cursor*> ps, std::vector<std::vector<uint32_t>> idxs, size_t num_vars)
+				: parts(std::move(ps)), indices(std::move(idxs)), reversed(parts.size(), false)
+			{
+				this->current = Assignment(num_vars);
+				for(auto part : this->parts)
+				{
+					part->interrupt = [this]() -> bool {
+						return this->interrupt && this->interrupt();
+					};
+
+					part->progress = [this](uint64_t done, uint64_t total) {
+						if(this->progress)
+							this->progress(done, total);
+					};
+
+					part->onFrontier = [this]() {
+						if(this->onFrontier)
+							this->onFrontier();
+					};
+				}
+			}
+
+			virtual ~ProductCursor() override
+			{
+				for(auto part : this->parts)
+					delete part;
+			}
+
+			virtual int forward() override { return this->step(/* backwards: */ false); }
+			virtual int backward() override { return this->step(/* backwards: */ true); }
+
+			virtual bool saveFrontier(Checkpoint* out) const override;
+			virtual bool loadFrontier(const Checkpoint& cp) override;
+
+			virtual size_t memoryUsage() const override
+			{
+				auto ret = sizeof(*this);
+				for(auto part : this->parts)
+					ret += part->memoryUsage();
+
+				return ret;
+			}
+
+			virtual bool count(BigNum* out) const override
+			{
+				auto ret = BigNum(1);
+				for(auto part : this->parts)
+				{
+					auto n = BigNum();
+					if(!part->count(&n))
+						return Cursor::count(out);
+
+					ret *= n;
+				}
+
+				*out = ret;
+				return true;
+			}
+
+			int step(bool backwards)
+			{
+				if(!this->hasCurrent)
+				{
+					// every part needs a solution before there's a solution at all; the ones that
+					// already have one (from an aborted attempt) can keep it.
+					for(auto part : this->parts)
+					{
+						if(part->valid())
+							continue;
+
+						if(auto r = part->next(); r != STEP_FOUND)
+							return r;
+					}
+
+					this->fill();
+					return STEP_FOUND;
+				}
+
+				// the last part moves the fastest. a part that can't go any further turns around
+				// and passes the step on to the one before it.
+				auto result = STEP_END;
+
+				size_t k = this->parts.size();
+				while(k > 0)
+				{
+					k -= 1;
+
+					auto part = this->parts[k];
+					auto r = (backwards != this->reversed[k]) ? part->prev() : part->next();
+
+					if(r == STEP_FOUND)
+					{
+						this->fill();
+						return STEP_FOUND;
+					}
+					else if(r == STEP_ABORTED)
+					{
+						result = STEP_ABORTED;
+						k += 1;
+						break;
+					}
+
+					this->reversed[k] = !this->reversed[k];
+				}
+
+				// nothing moved, so the parts that turned around need to turn back.
+				for(size_t i = k; i < this->parts.size(); i++)
+					this->reversed[i] = !this->reversed[i];
+
+				return result;
+			}
+
+			void fill()
+			{
+				for(size_t i = 0; i < this->parts.size(); i++)
+				{
+					auto& values = this->parts[i]->values();
+					for(size_t k = 0; k < this->indices[i].size(); k++)
+						this->current.set(this->indices[i][k], values.get(k));
+				}
+			}
+		};
+
+		struct BddCursor : Cursor
+		{
+			Bdd* bdd = nullptr;
+			Bdd::Node root = Bdd::FALSE;
+			BigNum solutions;
+
+			// the bdd's variables are in a different order from ours.
+			std::vector<uint32_t> levels;
+			Assignment scratch;
+
+			BddCursor(Bdd* b, Bdd::Node r, std::vector<uint32_t> ls) : bdd(b), root(r),
+				solutions(b->satCount(r)), levels(std::move(ls))
+			{
+				this->current = Assignment(b->numVars());
+			}
+
+			void unrank(uint64_t index);
+
+			virtual ~BddCursor() override { delete this->bdd; }
+
+			virtual int forward() override;
+			virtual int backward() override;
+			virtual bool count(BigNum* out) const override;
+			virtual size_t memoryUsage() const override { return sizeof(*this) + this->bdd->memoryUsage(); }
+		};
+	}
+
+	// products of products never get made, so the parts don't get parts of their own.
+	bool ProductCursor::saveFrontier(Checkpoint* out) const
+	{
+		out->reversed = this->reversed;
+		for(auto part : this->parts)
+		{
+			auto cp = Checkpoint();
+			if(!part->save(&cp) || !cp.parts.empty())
+				return false;
+
+			out->parts.push_back(std::move(cp));
+		}
+
+		return true;
+	}
+
+	bool ProductCursor::loadFrontier(const Checkpoint& cp)
+	{
+		if(cp.parts.size() != this->parts.size() || cp.reversed.size() != this->parts.size())
+			return false;
+
+		// if one of the parts won't take its checkpoint, the ones before it need to go back to
+		// the start, so that we can still start over from here.
+		auto fresh = std::vector<Checkpoint>(this->parts.size());
+		for(size_t i = 0; i < this->parts.size(); i++)
+			this->parts[i]->save(&fresh[i]);
+
+		for(size_t i = 0; i < this->parts.size(); i++)
+		{
+			// there's only a solution if every part had one.
+			auto& p = cp.parts[i];
+			if(!p.parts.empty() || (cp.hasCurrent && !p.hasCurrent) || !this->parts[i]->resume(p))
+			{
+				for(size_t k = 0; k < i; k++)
+					this->parts[k]->resume(fresh[k]);
+
+				return false;
+			}
+		}
+
+		this->reversed = cp.reversed;
+		if(cp.hasCurrent)
+			this->fill();
+
+		return true;
+	}
+
+	// progress is reported in assignments, but 2^64 of them doesn't fit.
+	static uint64_t to_rows(uint64_t blocks)
+	{
+		return blocks > (UINT64_MAX >> 6) ? UINT64_MAX : (blocks << 6);
+	}
+
+	// the first solution at or after `start` (or at or before, going backwards); each round hands a few
+	// chunks to every worker, and the closest hit wins.
+	int BruteForceCursor::search(uint64_t start, bool fwd)
+	{
+		auto nvars = this->tape.numVars;
+		auto lanes = Tape::laneMask(nvars);
+		auto first = start / 64;
+
+		// only the lanes on the far side of `start` count in the first block.
+		auto first_mask = lanes & (fwd
+			? (~0ULL << (start % 64))
+			: (start % 64 == 63 ? ~0ULL : (1ULL << (start % 64 + 1)) - 1));
+
+		auto blocks = fwd ? Tape::numBlocks(nvars) - first : first + 1;
+		auto chunks = (blocks + BLOCKS_PER_CHUNK - 1) / BLOCKS_PER_CHUNK;
+		auto per_round = CHUNKS_PER_WORKER * this->workers;
+
+		// both in scan order, ie. how many blocks away from `first`.
+		auto best = std::atomic<uint64_t>(UINT64_MAX);
+		auto scanned = std::atomic<uint64_t>(0);
+		auto aborted = std::atomic<bool>(false);
+
+		for(uint64_t round = 0; round < chunks && best == UINT64_MAX; round += per_round)
+		{
+			auto tasks = std::min(per_round, chunks - round);
+			if(this->pool != nullptr)
+			{
+				aborted = !this->scanRound(first, first_mask, fwd, blocks, round, tasks, best, scanned);
+			}
+			else
+			{
+				parallelFor(tasks, this->workers, [&](uint64_t task, size_t) -> bool {
+					if(this->interrupt && this->interrupt())
+					{
+						aborted = true;
+						return false;
+					}
+
+					auto begin = (round + task) * BLOCKS_PER_CHUNK;
+					auto end = std::min(blocks, begin + BLOCKS_PER_CHUNK);
+
+					// someone else already found something closer.
+					if(begin > best.load(std::memory_order_relaxed))
+						return true;
+
+					auto inputs = std::vector<uint64_t>(nvars);
+					auto slots = std::vector<uint64_t>(this->tape.ops.size());
+
+					for(auto i = begin; i < end; i++)
+					{
+						auto b = fwd ? first + i : first - i;
+						Tape::loadBlock(inputs.data(), nvars, b);
+
+						if(this->tape.run(inputs.data(), slots.data()) & (i == 0 ? first_mask : lanes))
+						{
+							auto cur = best.load();
+							while(i < cur && !best.compare_exchange_weak(cur, i))
+								;
+
+							break;
+						}
+					}
+
+					auto done = scanned.fetch_add(end - begin) + (end - begin);
+					if(this->progress)
+						this->progress(to_rows(done), to_rows(blocks));
+
+					return true;
+				});
+			}
+
+			if(aborted)
+				return STEP_ABORTED;
+
+			// nothing in this round, so the next search from here doesn't need to look at it again.
+			auto covered = std::min(blocks, (round + tasks) * BLOCKS_PER_CHUNK);
+			if(fwd && best == UINT64_MAX && covered < blocks)
+			{
+				this->scanned = 64 * (first + covered) - (this->hasCurrent ? this->row + 1 : 0);
+				if(this->onFrontier)
+					this->onFrontier();
+			}
+		}
+
+		if(best == UINT64_MAX)
+			return STEP_END;
+
+		// run the winning block again to see which lane it was.
+		auto b = fwd ? first + best : first - best;
+		auto inputs = std::vector<uint64_t>(nvars);
+		auto slots = std::vector<uint64_t>(this->tape.ops.size());
+
+		Tape::loadBlock(inputs.data(), nvars, b);
+		auto result = this->tape.run(inputs.data(), slots.data()) & (best == 0 ? first_mask : lanes);
+
+		// assignment number `row` is exactly the bits of the row number.
+		this->row = 64 * b + (fwd ? __builtin_ctzll(result) : 63 - __builtin_clzll(result));
+		this->scanned = 0;
+
+		if(nvars > 0)
+			this->current.words[0] = this->row;
+
+		return STEP_FOUND;
+	}
+
+	// the same as a round of search(), but in the pool's processes.
+	bool BruteForceCursor::scanRound(uint64_t first, uint64_t first_mask, bool fwd, uint64_t blocks, uint64_t round,
+		uint64_t tasks, std::atomic<uint64_t>& best, std::atomic<uint64_t>& scanned)
+	{
+		auto scan = WorkerPool::Scan();
+		scan.first = first;
+		scan.forward = fwd;
+		scan.begin = round * BLOCKS_PER_CHUNK;
+		scan.end = std::min(blocks, (round + tasks) * BLOCKS_PER_CHUNK);
+		scan.chunk = BLOCKS_PER_CHUNK;
+		scan.firstMask = first_mask;
+
+		auto hit = UINT64_MAX;
+		bool ok = this->pool->scan(this->tapeId, this->tape, scan, &hit, this->interrupt, [&](uint64_t n) {
+			auto done = scanned.fetch_add(n) + n;
+			if(this->progress)
+				this->progress(to_rows(done), to_rows(blocks));
+		});
+
+		best = hit;
+		return ok;
+	}
+
+	int BruteForceCursor::forward()
+	{
+		// the last row is all ones; with 64 variables, row + 1 would wrap around.
+		auto nvars = this->tape.numVars;
+		auto last = nvars >= 64 ? UINT64_MAX : (1ULL << nvars) - 1;
+		if(this->hasCurrent && this->row == last)
+			return STEP_END;
+
+		auto start = this->hasCurrent ? this->row + 1 : 0;
+		if(this->scanned > last - start)
+			return STEP_END;
+
+		return this->search(start + this->scanned, /* fwd: */ true);
+	}
+
+	int BruteForceCursor::backward()
+	{
+		if(this->row == 0)
+			return STEP_END;
+
+		return this->search(this->row - 1, /* fwd: */ false);
+	}
+
+	bool BruteForceCursor::saveFrontier(Checkpoint* out) const
+	{
+		out->row = this->row;
+		out->scanned = this->scanned;
+		return true;
+	}
+
+	bool BruteForceCursor::loadFrontier(const Checkpoint& cp)
+	{
+		auto nvars = this->tape.numVars;
+		if(nvars < 64 && (cp.row >> nvars) != 0)
+			return false;
+
+		this->row = cp.row;
+		this->scanned = cp.scanned;
+
+		if(cp.hasCurrent && nvars > 0)
+			this->current.words[0] = this->row;
+
+		return true;
+	}
+
+	static bool too_many_vars(const std::vector<std::string>& vars)
+	{
+		if(vars.size() <= MAX_BRUTE_FORCE_VARS)
+			return false;
+
+		lg::error("solver", "too many variables to brute-force ({}, max {})", vars.size(), MAX_BRUTE_FORCE_VARS);
+		return true;
+	}
+
+	Cursor* bruteForceCursor(const ast::Expr* expr, const std::vector<std::string>& vars, size_t num_workers)
+	{
+		if(too_many_vars(vars))
+			return nullptr;
+
+		return new BruteForceCursor(Tape::compile(expr, vars), std::max((size_t) 1, num_workers));
+	}
+
+	Cursor* processCursor(const ast::Expr* expr, const std::vector<std::string>& vars,
+		std::shared_ptr<WorkerPool> pool)
+	{
+		if(too_many_vars(vars))
+			return nullptr;
+
+		return new BruteForceCursor(Tape::compile(expr, vars), std::move(pool));
+	}
+
+
+
+	static uint64_t gray(uint64_t x)
+	{
+		return x ^ (x >> 1);
+	}
+
+	// moves the evaluator to gray(target), flipping only the variables that differ.
+	void GrayCodeCursor::seek(uint64_t target)
+	{
+		auto cur = gray(this->counter);
+		for(auto diff = cur ^ gray(target); diff != 0; diff &= diff - 1)
+		{
+			auto var = __builtin_ctzll(diff);
+			this->eval.set(var, !((cur >> var) & 1));
+		}
+
+		this->counter = target;
+	}
+
+	int GrayCodeCursor::walk(bool fwd)
+	{
+		// an aborted walk might have left the evaluator anywhere, so start from the current solution.
+		this->seek(this->hasCurrent ? this->row : 0);
+
+		auto last = this->nvars >= 64 ? UINT64_MAX : (1ULL << this->nvars) - 1;
+		auto start = this->counter;
+
+		// the first step of the very first search is assignment 0, which needs no flips.
+		bool check_first = fwd && !this->hasCurrent;
+
+		// an earlier walk from here got this far before it was interrupted.
+		if(fwd && this->scanned > 0)
+		{
+			this->seek(this->hasCurrent ? this->row + this->scanned : this->scanned - 1);
+			check_first = false;
+		}
+
+		for(uint64_t steps = 1; ; steps++)
+		{
+			if(!check_first)
+			{
+				if(fwd ? this->counter == last : this->counter == 0)
+					return STEP_END;
+
+				// going from counter i to i + 1 flips the bit at the position of the lowest set bit of i + 1.
+				auto bit = __builtin_ctzll(fwd ? this->counter + 1 : this->counter);
+				auto was = (gray(this->counter) >> bit) & 1;
+
+				this->eval.set(bit, !was);
+				if(fwd) this->counter++;
+				else    this->counter--;
+			}
+
+			check_first = false;
+			if(this->eval.result() == ast::TRI_TRUE)
+				break;
+
+			if(steps % GRAY_STEPS_PER_POLL == 0)
+			{
+				if(fwd)
+				{
+					this->scanned = this->hasCurrent ? this->counter - this->row : this->counter + 1;
+					if(this->onFrontier)
+						this->onFrontier();
+				}
+
+				if(this->interrupt && this->interrupt())
+					return STEP_ABORTED;
+
+				if(this->progress)
+				{
+					auto done = fwd ? this->counter - start : start - this->counter;
+					this->progress(done, fwd ? last - start : start);
+				}
+			}
+		}
+
+		this->row = this->counter;
+		this->scanned = 0;
+
+		if(this->nvars > 0)
+			this->current.words[0] = gray(this->row);
+
+		return STEP_FOUND;
+	}
+
+	int GrayCodeCursor::forward()
+	{
+		return this->walk(/* fwd: */ true);
+	}
+
+	int GrayCodeCursor::backward()
+	{
+		return this->walk(/* fwd: */ false);
+	}
+
+	bool GrayCodeCursor::saveFrontier(Checkpoint* out) const
+	{
+		out->row = this->row;
+		out->scanned = this->scanned;
+		return true;
+	}
+
+	bool GrayCodeCursor::loadFrontier(const Checkpoint& cp)
+	{
+		if(this->nvars < 64 && (cp.row >> this->nvars) != 0)
+			return false;
+
+		this->row = cp.row;
+		this->scanned = cp.scanned;
+
+		if(cp.hasCurrent && this->nvars > 0)
+			this->current.words[0] = gray(this->row);
+
+		return true;
+	}
+
+	Cursor* grayCodeCursor(const ast::Expr* expr, const std::vector<std::string>& vars)
+	{
+		if(too_many_vars(vars))
+			return nullptr;
+
+		return new GrayCodeCursor(expr, vars);
+	}
+
+
+
+	int SatCursor::forward()
+	{
+		auto next = this->hasCurrent ? this->position + 1 : 0;
+		if(this->recent.has(next))
+		{
+			this->current = this->recent.get(next);
+			return STEP_FOUND;
+		}
+
+		if(this->unsat)
+			return STEP_END;
+
+		auto res = this->sat.solve(this->assumptions);
+		if(res == Sat::RESULT_UNKNOWN)
+			return STEP_ABORTED;
+
+		if(res == Sat::RESULT_UNSAT)
+		{
+			this->unsat = true;
+			return STEP_END;
+		}
+
+		for(size_t k = 0; k < this->current.size(); k++)
+			this->current.set(k, this->sat.modelValue((uint32_t) k));
+
+		// the next model must differ from this one in at least one (free) variable.
+		auto block = std::vector<Lit>();
+		for(auto k : this->freeVars)
+			block.push_back(mkLit(k, /* neg: */ this->current.get(k)));
+
+		this->recent.push(next, this->current);
+		if(!this->sat.addClause(std::move(block)))
+			this->unsat = true;
+
+		return STEP_FOUND;
+	}
+
+	int SatCursor::backward()
+	{
+		this->current = this->recent.get(this->position - 1);
+		return STEP_FOUND;
+	}
+
+	Cursor* satCursor(const ast::Expr* expr, const std::vector<std::string>& vars, const PartialAssignment& pins)
+	{
+		auto ret = new SatCursor(vars.size());
+		ret->sat.addClause({ encodeTseitin(ret->sat, expr, vars) });
+		ret->sat.interrupt = [ret]() -> bool {
+			return ret->interrupt && ret->interrupt();
+		};
+
+		for(size_t k = 0; k < vars.size(); k++)
+		{
+			if(k < pins.size() && pins.isAssigned(k))
+				ret->assumptions.push_back(mkLit((uint32_t) k, /* neg: */ !pins.get(k)));
+			else
+				ret->freeVars.push_back((uint32_t) k);
+		}
+
+		return ret;
+	}
+
+	Cursor* projectedCursor(const ast::Expr* expr, const std::vector<std::string>& vars,
+		const PartialAssignment& pins, const std::vector<bool>& shown)
+	{
+		auto ret = static_cast<SatCursor*>(satCursor(expr, vars, pins));
+
+		// the hidden ones can be anything, as long as the shown ones haven't been seen before.
+		auto& fv = ret->freeVars;
+		fv.erase(std::remove_if(fv.begin(), fv.end(), [&shown](uint32_t k) -> bool {
+			return k < shown.size() && !shown[k];
+		}), fv.end());
+
+		return ret;
+	}
+
+
+
+	void BddCursor::unrank(uint64_t index)
+	{
+		this->bdd->solution(this->root, index, this->scratch);
+		for(size_t lv = 0; lv < this->levels.size(); lv++)
+			this->current.set(this->levels[lv], this->scratch.get(lv));
+	}
+
+	int BddCursor::forward()
+	{
+		this->unrank(this->hasCurrent ? this->position + 1 : 0);
+		return STEP_FOUND;
+	}
+
+	int BddCursor::backward()
+	{
+		this->unrank(this->position - 1);
+		return STEP_FOUND;
+	}
+
+	bool BddCursor::count(BigNum* out) const
+	{
+		*out = this->solutions;
+		return true;
+	}
+
+	Cursor* bddCursor(Bdd* bdd, Bdd::Node root, const std::vector<uint32_t>& levels)
+	{
+		return new BddCursor(bdd, root, levels);
+	}
+
+	Cursor* pinnedCursor(Cursor* inner, const PartialAssignment& pins)
+	{
+		return new PinnedCursor(inner, pins);
+	}
+
+	Cursor* productCursor(std::vector<Cursor*> parts, std::vector<std::vector<uint32_t>> indices, size_t num_vars)
+	{
+		return new ProductCursor(std::move(parts), std::move(indices), num_vars);
+	}
+}
@@ -0,0 +1,186 @@
+// equiv.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <unordered_set>
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	namespace
+	{
+		// a structurally hashed aig; edges are (node << 1) | negated, node 0 is false, and 1 to n are the variables.
+		struct Aig
+		{
+			static constexpr uint32_t FALSE = 0;
+			static constexpr uint32_t TRUE  = 1;
+
+			std::vector<std::pair<uint32_t, uint32_t>> fanins;
+			std::unordered_map<uint64_t, uint32_t> unique;
+			size_t numInputs = 0;
+
+			Aig(size_t num_vars) : fanins(1 + num_vars, { FALSE, FALSE }), numInputs(num_vars) { }
+
+			static uint32_t node(uint32_t edge) { return edge >> 1; }
+			bool isInput(uint32_t n) const { return n >= 1 && n <= this->numInputs; }
+
+			uint32_t input(uint32_t var) const { return (1 + var) << 1; }
+			uint32_t mkAnd(uint32_t a, uint32_t b);
+
+			uint32_t convert(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices);
+		};
+	}
+
+	uint32_t Aig::mkAnd(uint32_t a, uint32_t b)
+	{
+		if(a > b)
+			std::swap(a, b);
+
+		if(a == FALSE)      return FALSE;
+		if(a == TRUE)       return b;
+		if(a == b)          return a;
+		if(a == (b ^ 1))    return FALSE;
+
+		auto key = ((uint64_t) a << 32) | b;
+		if(auto it = this->unique.find(key); it != this->unique.end())
+			return it->second;
+
+		auto ret = (uint32_t) this->fanins.size() << 1;
+		this->fanins.emplace_back(a, b);
+
+		this->unique[key] = ret;
+		return ret;
+	}
+
+	uint32_t Aig::convert(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices)
+	{
+		if(auto l = dynamic_cast<const ast::Lit*>(expr); l != nullptr)
+		{
+			return l->value ? TRUE : FALSE;
+		}
+		else if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			auto it = indices.find(v->name);
+			if(it == indices.end())
+				lg::fatal("solver", "variable '{}' missing from the variable list", v->name);
+
+			return this->input(it->second);
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			return this->convert(n->e, indices) ^ 1;
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			// the things in a cut aren't in any order, so put the conjuncts in one before chaining
+			// them up; otherwise the same cut, drawn differently, would hash differently.
+			auto conjuncts = std::vector<const ast::Expr*>();
+			flattenAnd(a, conjuncts);
+
+			auto edges = std::vector<uint32_t>();
+			for(auto c : conjuncts)
+				edges.push_back(this->convert(c, indices));
+
+			std::sort(edges.begin(), edges.end());
+			edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+			auto ret = TRUE;
+			for(auto e : edges)
+				ret = this->mkAnd(ret, e);
+
+			return ret;
+		}
+		else
+		{
+			lg::fatal("solver", "invalid expression");
+		}
+	}
+
+	// tseitin-encodes the part of the aig under `root`; variable i is sat variable i.
+	static Lit encode_aig(Sat& sat, const Aig& aig, uint32_t root)
+	{
+		auto vars = std::unordered_map<uint32_t, uint32_t>();
+		auto lit_of = [&vars](uint32_t edge) -> Lit {
+			return mkLit(vars[Aig::node(edge)], /* neg: */ edge & 1);
+		};
+
+		auto stack = std::vector<uint32_t>({ Aig::node(root) });
+		auto order = std::vector<uint32_t>();
+		auto seen = std::unordered_set<uint32_t>();
+		while(!stack.empty())
+		{
+			auto n = stack.back();
+			stack.pop_back();
+
+			if(n == 0 || aig.isInput(n) || !seen.insert(n).second)
+				continue;
+
+			order.push_back(n);
+			stack.push_back(Aig::node(aig.fanins[n].first));
+			stack.push_back(Aig::node(aig.fanins[n].second));
+		}
+
+		for(size_t i = 0; i < aig.numInputs; i++)
+			vars[(uint32_t) (1 + i)] = (uint32_t) i;
+
+		// the aig is built bottom-up, so the fanins of a node always come before it.
+		std::sort(order.begin(), order.end());
+		for(auto n : order)
+		{
+			auto [ a, b ] = aig.fanins[n];
+			auto g = sat.newVar();
+			vars[n] = g;
+
+			// g <-> (a & b)
+			sat.addClause({ mkLit(g, true), lit_of(a) });
+			sat.addClause({ mkLit(g, true), lit_of(b) });
+			sat.addClause({ mkLit(g), negate(lit_of(a)), negate(lit_of(b)) });
+		}
+
+		return lit_of(root);
+	}
+
+	int checkEquivalence(const ast::Expr* a, const ast::Expr* b, const std::vector<std::string>& vars,
+		Assignment* witness, const std::function<bool ()>& interrupt)
+	{
+		auto indices = std::unordered_map<std::string, uint32_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = (uint32_t) i;
+
+		auto aig = Aig(vars.size());
+		auto ra = aig.convert(a, indices);
+		auto rb = aig.convert(b, indices);
+
+		// most of the time, equivalent expressions come out as the same node without any search.
+		if(ra == rb)
+			return EQUIV_SAME;
+
+		// the miter is (a xor b), which is just (a | b) & !(a & b).
+		auto miter = aig.mkAnd(aig.mkAnd(ra ^ 1, rb ^ 1) ^ 1, aig.mkAnd(ra, rb) ^ 1);
+		if(miter == Aig::FALSE)
+			return EQUIV_SAME;
+
+		auto sat = Sat();
+		sat.interrupt = interrupt;
+		while(sat.numVars() < vars.size())
+			sat.newVar();
+
+		if(miter != Aig::TRUE)
+			sat.addClause({ encode_aig(sat, aig, miter) });
+
+		auto result = sat.solve();
+		if(result == Sat::RESULT_UNKNOWN)
+			return EQUIV_UNKNOWN;
+
+		if(result == Sat::RESULT_UNSAT)
+			return EQUIV_SAME;
+
+		*witness = Assignment(vars.size());
+		for(size_t i = 0; i < vars.size(); i++)
+			witness->set(i, sat.modelValue((uint32_t) i));
+
+		return EQUIV_DIFFERENT;
+	}
+}
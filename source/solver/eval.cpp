@@ -0,0 +1,189 @@
+// eval.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	static constexpr uint8_t NODE_VAR   = 1;
+	static constexpr uint8_t NODE_LIT   = 2;
+	static constexpr uint8_t NODE_AND   = 3;
+	static constexpr uint8_t NODE_NOT   = 4;
+
+	static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+	Evaluator::Evaluator(const ast::Expr* expr, const std::vector<std::string>& vars)
+		: occurrences(vars.size()), current(vars.size())
+	{
+		auto indices = std::unordered_map<std::string, uint32_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = (uint32_t) i;
+
+		// children always come before their parents, so one pass in order evaluates everything.
+		this->add(expr, indices);
+		for(auto& node : this->nodes)
+			node.value = this->compute(node);
+	}
+
+	uint32_t Evaluator::add(const ast::Expr* expr, const std::unordered_map<std::string, uint32_t>& indices)
+	{
+		auto node = Node { 0, ast::TRI_UNKNOWN, 0, 0, NO_PARENT };
+
+		if(auto l = dynamic_cast<const ast::Lit*>(expr); l != nullptr)
+		{
+			node.kind = NODE_LIT;
+			node.a = l->value;
+		}
+		else if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			auto it = indices.find(v->name);
+			if(it == indices.end())
+				lg::fatal("solver", "unknown variable '{}'", v->name);
+
+			node.kind = NODE_VAR;
+			node.a = it->second;
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			node.kind = NODE_NOT;
+			node.a = this->add(n->e, indices);
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			node.kind = NODE_AND;
+			node.a = this->add(a->left, indices);
+			node.b = this->add(a->right, indices);
+		}
+		else
+		{
+			lg::fatal("solver", "invalid expression");
+		}
+
+		auto idx = (uint32_t) this->nodes.size();
+		this->nodes.push_back(node);
+
+		if(node.kind == NODE_VAR)
+		{
+			this->occurrences[node.a].push_back(idx);
+		}
+		else if(node.kind == NODE_NOT)
+		{
+			this->nodes[node.a].parent = idx;
+		}
+		else if(node.kind == NODE_AND)
+		{
+			this->nodes[node.a].parent = idx;
+			this->nodes[node.b].parent = idx;
+		}
+
+		return idx;
+	}
+
+	uint8_t Evaluator::compute(const Node& node) const
+	{
+		switch(node.kind)
+		{
+			case NODE_LIT:
+				return node.a ? ast::TRI_TRUE : ast::TRI_FALSE;
+
+			case NODE_VAR:
+				if(!this->current.isAssigned(node.a))
+					return ast::TRI_UNKNOWN;
+
+				return this->current.get(node.a) ? ast::TRI_TRUE : ast::TRI_FALSE;
+
+			case NODE_NOT: {
+				auto x = this->nodes[node.a].value;
+				return x == ast::TRI_UNKNOWN ? x : (x == ast::TRI_TRUE ? ast::TRI_FALSE : ast::TRI_TRUE);
+			}
+
+			case NODE_AND: {
+				auto l = this->nodes[node.a].value;
+				auto r = this->nodes[node.b].value;
+				if(l == ast::TRI_FALSE || r == ast::TRI_FALSE)
+					return ast::TRI_FALSE;
+
+				return (l == ast::TRI_TRUE && r == ast::TRI_TRUE) ? ast::TRI_TRUE : ast::TRI_UNKNOWN;
+			}
+
+			default:
+				lg::fatal("solver", "invalid node");
+		}
+	}
+
+	void Evaluator::assign(uint32_t var, uint8_t value)
+	{
+		if(value == ast::TRI_UNKNOWN)   this->current.unset(var);
+		else                            this->current.set(var, value == ast::TRI_TRUE);
+
+		for(auto occ : this->occurrences[var])
+		{
+			this->nodes[occ].value = value;
+
+			// everything above this point already agrees with what we'd compute.
+			for(auto n = this->nodes[occ].parent; n != NO_PARENT; n = this->nodes[n].parent)
+			{
+				auto x = this->compute(this->nodes[n]);
+				if(x == this->nodes[n].value)
+					break;
+
+				this->nodes[n].value = x;
+			}
+		}
+	}
+
+	void Evaluator::set(uint32_t var, bool value)
+	{
+		this->assign(var, value ? ast::TRI_TRUE : ast::TRI_FALSE);
+	}
+
+	void Evaluator::unset(uint32_t var)
+	{
+		this->assign(var, ast::TRI_UNKNOWN);
+	}
+
+	void Evaluator::update(const PartialAssignment& assigns, std::vector<uint32_t>& changed)
+	{
+		changed.clear();
+		if(assigns.size() != this->current.size())
+			lg::fatal("solver", "assignment has {} variables, expected {}", assigns.size(), this->current.size());
+
+		auto& words = this->current.values.words;
+		for(size_t w = 0; w < words.size(); w++)
+		{
+			auto diff = (words[w] ^ assigns.values.words[w])
+				| (this->current.assigned.words[w] ^ assigns.assigned.words[w]);
+
+			while(diff != 0)
+			{
+				auto var = (uint32_t) (64 * w + __builtin_ctzll(diff));
+				diff &= diff - 1;
+
+				this->assign(var, !assigns.isAssigned(var)
+					? ast::TRI_UNKNOWN
+					: (assigns.get(var) ? ast::TRI_TRUE : ast::TRI_FALSE));
+
+				changed.push_back(var);
+			}
+		}
+	}
+
+	size_t Evaluator::memoryUsage() const
+	{
+		auto ret = sizeof(Evaluator) + this->nodes.size() * sizeof(Node);
+		for(auto& occ : this->occurrences)
+			ret += sizeof(occ) + occ.size() * sizeof(uint32_t);
+
+		return ret;
+	}
+
+	int Evaluator::result() const
+	{
+		if(this->nodes.empty())
+			return ast::TRI_UNKNOWN;
+
+		return this->nodes.back().value;
+	}
+}
@@ -0,0 +1,216 @@
+// hash.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <cmath>
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	static bool xor_bit(const XorRow& row, size_t i)
+	{
+		return (row[i / 64] >> (i % 64)) & 1;
+	}
+
+	std::vector<XorRow> randomXors(std::mt19937_64& rng, size_t num_vars, size_t count)
+	{
+		auto words = (num_vars + 1 + 63) / 64;
+		auto rows = std::vector<XorRow>();
+		for(size_t k = 0; k < count; k++)
+		{
+			auto& row = rows.emplace_back(words, 0);
+			for(size_t i = 0; i <= num_vars; i++)
+			{
+				if(rng() & 1)
+					row[i / 64] |= 1ULL << (i % 64);
+			}
+		}
+
+		return rows;
+	}
+
+	// (x_1 xor ... xor x_k) = parity, as a chain with a new variable for each link.
+	static void add_xor(Sat& sat, const std::vector<uint32_t>& xs, bool parity)
+	{
+		if(xs.empty())
+		{
+			if(parity)
+				sat.addClause({ });
+
+			return;
+		}
+
+		auto acc = mkLit(xs[0]);
+		for(size_t i = 1; i < xs.size(); i++)
+		{
+			auto x = mkLit(xs[i]);
+			auto t = mkLit(sat.newVar());
+
+			// t <-> (acc xor x)
+			sat.addClause({ negate(t), acc, x });
+			sat.addClause({ negate(t), negate(acc), negate(x) });
+			sat.addClause({ t, negate(acc), x });
+			sat.addClause({ t, acc, negate(x) });
+			acc = t;
+		}
+
+		sat.addClause({ parity ? acc : negate(acc) });
+	}
+
+	void addXors(Sat& sat, std::vector<XorRow> rows, size_t num_vars)
+	{
+		// gauss-jordan: each pivot column gets cleared out of every other row.
+		size_t rank = 0;
+		for(size_t col = 0; col < num_vars && rank < rows.size(); col++)
+		{
+			auto pivot = rank;
+			while(pivot < rows.size() && !xor_bit(rows[pivot], col))
+				pivot++;
+
+			if(pivot == rows.size())
+				continue;
+
+			std::swap(rows[pivot], rows[rank]);
+			for(size_t r = 0; r < rows.size(); r++)
+			{
+				if(r == rank || !xor_bit(rows[r], col))
+					continue;
+
+				for(size_t w = 0; w < rows[r].size(); w++)
+					rows[r][w] ^= rows[rank][w];
+			}
+
+			rank++;
+		}
+
+		for(auto& row : rows)
+		{
+			auto xs = std::vector<uint32_t>();
+			for(size_t i = 0; i < num_vars; i++)
+			{
+				if(xor_bit(row, i))
+					xs.push_back((uint32_t) i);
+			}
+
+			// anything that cancelled out entirely is either 0 = 0, or 0 = 1 (which nothing satisfies).
+			add_xor(sat, xs, xor_bit(row, num_vars));
+		}
+	}
+
+	// the number of solutions (up to `limit`) that also satisfy the xors; returns SIZE_MAX if interrupted.
+	static size_t bounded_count(const ast::Expr* expr, const std::vector<std::string>& vars,
+		const std::vector<XorRow>& rows, size_t limit, const std::function<bool ()>& interrupt)
+	{
+		auto sat = Sat();
+		sat.interrupt = interrupt;
+		sat.addClause({ encodeTseitin(sat, expr, vars) });
+		addXors(sat, rows, vars.size());
+
+		size_t count = 0;
+		while(count < limit)
+		{
+			auto result = sat.solve();
+			if(result == Sat::RESULT_UNKNOWN)
+				return SIZE_MAX;
+
+			if(result == Sat::RESULT_UNSAT)
+				break;
+
+			count++;
+
+			auto block = std::vector<Lit>();
+			for(size_t i = 0; i < vars.size(); i++)
+				block.push_back(mkLit((uint32_t) i, /* neg: */ sat.modelValue((uint32_t) i)));
+
+			if(!sat.addClause(std::move(block)))
+				break;
+		}
+
+		return count;
+	}
+
+	bool approxCount(const ast::Expr* expr, const std::vector<std::string>& vars, double epsilon, double delta,
+		uint64_t seed, BigNum* out, bool* exact, const std::function<bool ()>& interrupt,
+		const std::function<void (uint64_t, uint64_t)>& progress)
+	{
+		// these are the numbers from the approxmc paper, which is where the guarantee comes from.
+		auto threshold = (size_t) std::ceil(1 + 9.84 * (1 + epsilon / (1 + epsilon)) * std::pow(1 + 1 / epsilon, 2));
+		auto rounds = (size_t) std::ceil(17 * std::log2(3 / delta));
+
+		auto n = vars.size();
+		auto rng = std::mt19937_64(seed);
+
+		// if there aren't many solutions to begin with, we can just count them.
+		auto total = bounded_count(expr, vars, { }, threshold, interrupt);
+		if(total == SIZE_MAX)
+			return false;
+
+		if(total < threshold)
+		{
+			*out = BigNum(total);
+			*exact = true;
+			return true;
+		}
+
+		auto estimates = std::vector<BigNum>();
+		size_t last = 1;
+
+		for(size_t round = 0; round < rounds; round++)
+		{
+			if(progress)
+				progress(round, rounds);
+
+			// each cell is inside the one with one fewer xor, so search for the first m that's small enough.
+			auto rows = randomXors(rng, n, n);
+			auto sizes = std::unordered_map<size_t, size_t>();
+			auto size_at = [&](size_t m) -> size_t {
+				if(auto it = sizes.find(m); it != sizes.end())
+					return it->second;
+
+				return (sizes[m] = bounded_count(expr, vars, std::vector<XorRow>(rows.begin(), rows.begin() + m),
+					threshold, interrupt));
+			};
+
+			size_t lo = 0;
+			size_t hi = n;
+			auto probe = [&](size_t m) -> bool {
+				auto s = size_at(m);
+				if(s == SIZE_MAX)
+					return false;
+
+				(s >= threshold ? lo : hi) = m;
+				return true;
+			};
+
+			// it's usually within one of where it was last round, so look there first.
+			for(auto m : { last, last - 1, last + 1 })
+			{
+				if(m > lo && m < hi && !probe(m))
+					return false;
+			}
+
+			while(hi - lo > 1)
+			{
+				if(!probe(lo + (hi - lo) / 2))
+					return false;
+			}
+
+			auto cell = size_at(hi);
+			if(cell == SIZE_MAX)
+				return false;
+
+			estimates.push_back(BigNum(cell) << hi);
+			last = hi;
+		}
+
+		if(progress)
+			progress(rounds, rounds);
+
+		std::sort(estimates.begin(), estimates.end());
+		*out = estimates[estimates.size() / 2];
+		*exact = false;
+		return true;
+	}
+}
@@ -0,0 +1,119 @@
+// job.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "solver.h"
+
+namespace solver
+{
+	void Job::setProgress(uint64_t done, uint64_t total)
+	{
+		this->total.store(total);
+		this->done.store(done);
+	}
+
+	std::function<bool ()> Job::interruptor()
+	{
+		return [this]() -> bool {
+			return this->isCancelled();
+		};
+	}
+
+	std::function<void (uint64_t, uint64_t)> Job::reporter()
+	{
+		return [this](uint64_t done, uint64_t total) {
+			this->setProgress(done, total);
+		};
+	}
+
+	double Job::elapsed() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->started).count();
+	}
+
+	double Job::rate() const
+	{
+		auto secs = this->elapsed();
+		auto done = this->done.load();
+
+		// the first few moments are mostly setup, so the rate would be all over the place.
+		if(secs < 0.25 || done == 0)
+			return -1;
+
+		return (double) done / secs;
+	}
+
+	double Job::remaining() const
+	{
+		auto [ done, total ] = this->progress();
+		auto r = this->rate();
+		if(total == 0 || r <= 0)
+			return -1;
+
+		return (double) (total - std::min(done, total)) / r;
+	}
+
+	JobRunner::~JobRunner()
+	{
+		this->stop();
+	}
+
+	std::shared_ptr<Job> JobRunner::start(Work work)
+	{
+		auto job = std::make_shared<Job>();
+		auto t = std::thread([this](std::shared_ptr<Job> job, Work work) {
+			auto callback = work(*job);
+
+			// the job has to stay alive until its callback runs.
+			auto lk = std::lock_guard(this->lock);
+			job->finished.store(true);
+			this->completed.emplace_back(std::move(job), std::move(callback));
+		}, job, std::move(work));
+
+		this->running.emplace_back(job, std::move(t));
+		return job;
+	}
+
+	void JobRunner::stop()
+	{
+		for(auto& [ job, t ] : this->running)
+			job->cancel();
+
+		for(auto& [ job, t ] : this->running)
+			t.join();
+
+		this->running.clear();
+
+		auto lk = std::lock_guard(this->lock);
+		this->completed.clear();
+	}
+
+	void JobRunner::poll()
+	{
+		// a finished job's thread is only returning, so joining it doesn't wait.
+		for(auto it = this->running.begin(); it != this->running.end(); )
+		{
+			if(it->first->isFinished())
+			{
+				it->second.join();
+				it = this->running.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		auto callbacks = decltype(this->completed)();
+		{
+			auto lk = std::lock_guard(this->lock);
+			callbacks.swap(this->completed);
+		}
+
+		for(auto& [ job, cb ] : callbacks)
+		{
+			if(cb)
+				cb();
+		}
+	}
+}
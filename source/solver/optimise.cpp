@@ -0,0 +1,122 @@
+// optimise.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	// how many branches to take between checking for aborts.
+	static constexpr uint64_t NODES_PER_POLL = 1 << 12;
+
+	namespace
+	{
+		struct Search
+		{
+			Evaluator eval;
+			const std::vector<int64_t>& weights;
+
+			// the order that the variables get decided in, and the most that the ones from each point
+			// onwards could take off the weight (the sum of their negative weights).
+			std::vector<uint32_t> order;
+			std::vector<int64_t> slack;
+
+			Assignment current;
+			int64_t cost = 0;
+
+			bool found = false;
+			int64_t best = 0;
+			Assignment bestSoln;
+
+			uint64_t nodes = 0;
+			bool aborted = false;
+			std::function<bool ()> interrupt;
+
+			Search(const ast::Expr* expr, const std::vector<std::string>& vars, const std::vector<int64_t>& ws)
+				: eval(expr, vars), weights(ws), current(vars.size()) { }
+
+			void search(size_t depth);
+		};
+	}
+
+	void Search::search(size_t depth)
+	{
+		if(this->aborted)
+			return;
+
+		if(++this->nodes % NODES_PER_POLL == 0 && this->interrupt && this->interrupt())
+		{
+			this->aborted = true;
+			return;
+		}
+
+		// even if everything left went our way, it wouldn't beat what we already have.
+		if(this->found && this->cost + this->slack[depth] >= this->best)
+			return;
+
+		auto result = this->eval.result();
+		if(result == ast::TRI_FALSE)
+			return;
+
+		if(result == ast::TRI_TRUE)
+		{
+			auto soln = this->current;
+			for(size_t k = depth; k < this->order.size(); k++)
+				soln.set(this->order[k], this->weights[this->order[k]] < 0);
+
+			this->found = true;
+			this->best = this->cost + this->slack[depth];
+			this->bestSoln = std::move(soln);
+			return;
+		}
+
+		auto var = this->order[depth];
+		auto w = this->weights[var];
+
+		// the cheaper value first, so that good solutions (and so tight bounds) turn up early.
+		auto first = (w < 0);
+		for(bool value : { first, !first })
+		{
+			this->current.set(var, value);
+			this->eval.set(var, value);
+
+			this->cost += (value ? w : 0);
+			this->search(depth + 1);
+			this->cost -= (value ? w : 0);
+		}
+
+		this->current.set(var, false);
+		this->eval.unset(var);
+	}
+
+	int minimiseWeight(const ast::Expr* expr, const std::vector<std::string>& vars, const std::vector<int64_t>& weights,
+		Assignment* out, int64_t* cost, const std::function<bool ()>& interrupt)
+	{
+		auto s = Search(expr, vars, weights);
+		s.interrupt = interrupt;
+
+		// the heaviest first, since those are the ones that move the bound the most; otherwise, in
+		// the order they turn up, so that related variables get decided together.
+		s.order = firstAppearanceOrder(expr, vars, /* everything: */ true);
+		std::stable_sort(s.order.begin(), s.order.end(), [&weights](uint32_t a, uint32_t b) {
+			return std::abs(weights[a]) > std::abs(weights[b]);
+		});
+
+		s.slack.resize(vars.size() + 1, 0);
+		for(size_t k = vars.size(); k-- > 0; )
+			s.slack[k] = s.slack[k + 1] + std::min(weights[s.order[k]], (int64_t) 0);
+
+		s.search(0);
+
+		if(s.aborted)
+			return Sat::RESULT_UNKNOWN;
+
+		if(!s.found)
+			return Sat::RESULT_UNSAT;
+
+		*out = std::move(s.bestSoln);
+		*cost = s.best;
+		return Sat::RESULT_SAT;
+	}
+}
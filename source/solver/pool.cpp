@@ -0,0 +1,128 @@
+// pool.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+
+#include "solver.h"
+
+namespace solver
+{
+	namespace
+	{
+		// the tasks that a worker has yet to run: [begin, end).
+		struct Range
+		{
+			std::mutex lock;
+			uint64_t begin = 0;
+			uint64_t end = 0;
+		};
+	}
+
+	static bool take_own(Range& range, uint64_t* task)
+	{
+		auto lk = std::lock_guard(range.lock);
+		if(range.begin == range.end)
+			return false;
+
+		*task = range.begin++;
+		return true;
+	}
+
+	// returns false if there's nothing left to steal anywhere.
+	static bool steal(std::vector<Range>& ranges, size_t self)
+	{
+		size_t victim = self;
+		uint64_t most = 0;
+		for(size_t i = 0; i < ranges.size(); i++)
+		{
+			auto lk = std::lock_guard(ranges[i].lock);
+			if(auto n = ranges[i].end - ranges[i].begin; n > most)
+				victim = i, most = n;
+		}
+
+		if(most == 0)
+			return false;
+
+		uint64_t begin = 0;
+		uint64_t end = 0;
+		{
+			// things might have changed since we looked, so check again. note that we must not hold
+			// the victim's lock while taking our own, otherwise two thieves can deadlock each other.
+			auto& v = ranges[victim];
+			auto lk = std::lock_guard(v.lock);
+
+			begin = v.begin + (v.end - v.begin) / 2;
+			end = v.end;
+			v.end = begin;
+		}
+
+		// only the owner ever grows its own range, so this is fine.
+		auto& mine = ranges[self];
+		auto lk = std::lock_guard(mine.lock);
+		mine.begin = begin;
+		mine.end = end;
+
+		return true;
+	}
+
+	void parallelFor(uint64_t num_tasks, size_t num_workers,
+		const std::function<bool (uint64_t task, size_t worker)>& fn)
+	{
+		if(num_tasks == 0)
+			return;
+
+		num_workers = std::max((size_t) 1, num_workers);
+		if(num_tasks < num_workers)
+			num_workers = (size_t) num_tasks;
+
+		auto ranges = std::vector<Range>(num_workers);
+		{
+			auto share = num_tasks / num_workers;
+			auto extra = num_tasks % num_workers;
+
+			uint64_t begin = 0;
+			for(size_t i = 0; i < num_workers; i++)
+			{
+				ranges[i].begin = begin;
+				ranges[i].end = begin + share + (i < extra ? 1 : 0);
+				begin = ranges[i].end;
+			}
+		}
+
+		std::atomic<bool> stop = false;
+		auto work = [&](size_t self) {
+			while(!stop.load(std::memory_order_relaxed))
+			{
+				uint64_t task = 0;
+				if(!take_own(ranges[self], &task))
+				{
+					if(steal(ranges, self))
+						continue;
+
+					break;
+				}
+
+				if(!fn(task, self))
+					stop = true;
+			}
+		};
+
+		auto threads = std::vector<std::thread>();
+		for(size_t i = 1; i < num_workers; i++)
+			threads.emplace_back(work, i);
+
+		// the calling thread is worker 0.
+		work(0);
+
+		for(auto& t : threads)
+			t.join();
+	}
+
+	size_t numHardwareThreads()
+	{
+		return std::max((size_t) 1, (size_t) std::thread::hardware_concurrency());
+	}
+}
@@ -0,0 +1,243 @@
+// sample.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	// the most solutions that a cell of the xor sampler can have; bigger cells are closer to
+	// uniform, but take longer to list out.
+	static constexpr size_t CELL_SIZE = 32;
+
+	namespace
+	{
+		struct BddSampler : Sampler
+		{
+			Bdd* bdd = nullptr;
+			Bdd::Node root = Bdd::FALSE;
+			std::vector<uint32_t> levels;
+			Assignment scratch;
+
+			BddSampler(Bdd* b, Bdd::Node r, std::vector<uint32_t> ls) : bdd(b), root(r), levels(std::move(ls)) { }
+			virtual ~BddSampler() override { delete this->bdd; }
+
+			virtual int draw(std::mt19937_64& rng, Assignment& out) override;
+			virtual size_t memoryUsage() const override { return sizeof(*this) + this->bdd->memoryUsage(); }
+		};
+
+		struct XorSampler : Sampler
+		{
+			ast::Expr* expr = nullptr;
+			std::vector<std::string> vars;
+			size_t hashes = 0;
+
+			// if there are only a few solutions, they all fit in one cell, and we can just keep them.
+			bool small = false;
+			std::vector<Assignment> solutions;
+
+			XorSampler(const ast::Expr* e, std::vector<std::string> vs) : expr(e->evaluate({ })), vars(std::move(vs)) { }
+			virtual ~XorSampler() override { delete this->expr; }
+
+			int listCell(std::mt19937_64& rng, std::vector<Assignment>& cell);
+
+			virtual int draw(std::mt19937_64& rng, Assignment& out) override;
+			virtual size_t memoryUsage() const override
+			{
+				return sizeof(*this) + this->solutions.size() * (sizeof(Assignment) + (this->vars.size() + 7) / 8);
+			}
+		};
+
+		struct SampleCursor : Cursor
+		{
+			Sampler* sampler = nullptr;
+			std::mt19937_64 rng;
+			size_t limit = 0;
+			bool unsat = false;
+
+			std::vector<uint32_t> freeVars;
+			Assignment scratch;
+
+			// so that going back shows the same ones again.
+			RecentSolutions recent;
+
+			SampleCursor(Sampler* s, const PartialAssignment& pins, size_t lim, uint64_t seed)
+				: sampler(s), rng(seed), limit(lim)
+			{
+				// the pinned values never change, so they can go in once.
+				this->current = pins.values;
+				for(size_t k = 0; k < pins.size(); k++)
+				{
+					if(!pins.isAssigned(k))
+						this->freeVars.push_back((uint32_t) k);
+				}
+
+				this->sampler->interrupt = [this]() -> bool {
+					return this->interrupt && this->interrupt();
+				};
+			}
+
+			virtual ~SampleCursor() override { delete this->sampler; }
+
+			virtual int forward() override;
+			virtual int backward() override;
+
+			virtual bool hasNext() const override
+			{
+				return !this->unsat && (this->hasCurrent ? this->position + 1 : 0) < this->limit;
+			}
+
+			virtual bool hasPrev() const override
+			{
+				return Cursor::hasPrev() && this->recent.has(this->position - 1);
+			}
+
+			// we only ever see a few of the solutions, so we never know how many there are.
+			virtual bool count(BigNum* out) const override { return false; }
+			virtual bool isSample() const override { return true; }
+
+			virtual size_t memoryUsage() const override
+			{
+				return sizeof(*this) + this->sampler->memoryUsage() + RecentSolutions::memoryUsage(this->current.size());
+			}
+		};
+	}
+
+	int BddSampler::draw(std::mt19937_64& rng, Assignment& out)
+	{
+		if(this->root == Bdd::FALSE)
+			return Sat::RESULT_UNSAT;
+
+		this->bdd->randomSolution(this->root, rng, this->scratch);
+		for(size_t lv = 0; lv < this->levels.size(); lv++)
+			out.set(this->levels[lv], this->scratch.get(lv));
+
+		return Sat::RESULT_SAT;
+	}
+
+	// lists up to CELL_SIZE + 1 of the solutions that satisfy `hashes` random xors.
+	int XorSampler::listCell(std::mt19937_64& rng, std::vector<Assignment>& cell)
+	{
+		// a fresh solver each time, so the old xors (and what was learnt from them) don't pile up.
+		auto sat = Sat();
+		sat.interrupt = this->interrupt;
+		sat.addClause({ encodeTseitin(sat, this->expr, this->vars) });
+
+		auto n = this->vars.size();
+		addXors(sat, randomXors(rng, n, this->hashes), n);
+
+		while(cell.size() <= CELL_SIZE)
+		{
+			auto result = sat.solve();
+			if(result == Sat::RESULT_UNKNOWN)
+				return result;
+
+			if(result == Sat::RESULT_UNSAT)
+				break;
+
+			auto& soln = cell.emplace_back(this->vars.size());
+			auto block = std::vector<Lit>();
+			for(size_t i = 0; i < this->vars.size(); i++)
+			{
+				soln.set(i, sat.modelValue((uint32_t) i));
+				block.push_back(mkLit((uint32_t) i, /* neg: */ soln.get(i)));
+			}
+
+			if(!sat.addClause(std::move(block)))
+				break;
+		}
+
+		return Sat::RESULT_SAT;
+	}
+
+	int XorSampler::draw(std::mt19937_64& rng, Assignment& out)
+	{
+		while(!this->small)
+		{
+			if(this->interrupt && this->interrupt())
+				return Sat::RESULT_UNKNOWN;
+
+			auto cell = std::vector<Assignment>();
+			if(this->listCell(rng, cell) == Sat::RESULT_UNKNOWN)
+				return Sat::RESULT_UNKNOWN;
+
+			if(this->hashes == 0 && cell.size() <= CELL_SIZE)
+			{
+				this->small = true;
+				this->solutions = std::move(cell);
+				break;
+			}
+
+			if(cell.size() > CELL_SIZE)
+			{
+				this->hashes++;
+				continue;
+			}
+
+			// every solution lands in a given cell with the same chance, so taking a cell with k
+			// solutions k times in CELL_SIZE makes every solution come out with the same chance.
+			if(rng() % CELL_SIZE >= cell.size())
+				continue;
+
+			out = cell[rng() % cell.size()];
+			return Sat::RESULT_SAT;
+		}
+
+		if(this->solutions.empty())
+			return Sat::RESULT_UNSAT;
+
+		out = this->solutions[rng() % this->solutions.size()];
+		return Sat::RESULT_SAT;
+	}
+
+	int SampleCursor::forward()
+	{
+		auto next = this->hasCurrent ? this->position + 1 : 0;
+		if(this->recent.has(next))
+		{
+			this->current = this->recent.get(next);
+			return STEP_FOUND;
+		}
+
+		if(this->scratch.size() != this->freeVars.size())
+			this->scratch = Assignment(this->freeVars.size());
+
+		auto result = this->sampler->draw(this->rng, this->scratch);
+		if(result == Sat::RESULT_UNKNOWN)
+			return STEP_ABORTED;
+
+		if(result == Sat::RESULT_UNSAT)
+		{
+			this->unsat = true;
+			return STEP_END;
+		}
+
+		for(size_t k = 0; k < this->freeVars.size(); k++)
+			this->current.set(this->freeVars[k], this->scratch.get(k));
+
+		this->recent.push(next, this->current);
+		return STEP_FOUND;
+	}
+
+	int SampleCursor::backward()
+	{
+		this->current = this->recent.get(this->position - 1);
+		return STEP_FOUND;
+	}
+
+	Sampler* bddSampler(Bdd* bdd, Bdd::Node root, const std::vector<uint32_t>& levels)
+	{
+		return new BddSampler(bdd, root, levels);
+	}
+
+	Sampler* xorSampler(const ast::Expr* expr, const std::vector<std::string>& vars)
+	{
+		return new XorSampler(expr, vars);
+	}
+
+	Cursor* sampleCursor(Sampler* sampler, const PartialAssignment& pins, size_t limit, uint64_t seed)
+	{
+		return new SampleCursor(sampler, pins, limit, seed);
+	}
+}
@@ -0,0 +1,669 @@
+// sat.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <math.h>
+
+#include "solver.h"
+
+namespace solver
+{
+	static constexpr uint8_t VAL_FALSE  = 0;
+	static constexpr uint8_t VAL_TRUE   = 1;
+	static constexpr uint8_t VAL_UNDEF  = 2;
+
+	static constexpr uint32_t NO_REASON = UINT32_MAX;
+	static constexpr Lit NO_LIT         = UINT32_MAX;
+
+	static constexpr double VAR_DECAY       = 0.95;
+	static constexpr double CLAUSE_DECAY    = 0.999;
+	static constexpr int RESTART_BASE       = 100;
+
+	namespace
+	{
+		struct Clause
+		{
+			std::vector<Lit> lits;
+			bool learnt = false;
+			double activity = 0;
+		};
+
+		struct Watcher
+		{
+			uint32_t clause;
+
+			// if this literal is true, the clause is satisfied and we can skip looking at it.
+			Lit blocker;
+		};
+	}
+
+	struct SatState
+	{
+		bool ok = true;
+
+		std::vector<Clause> clauses;
+		size_t numLearnts = 0;
+		size_t maxLearnts = 0;
+
+		// watches[lit] are the clauses watching `lit`, which we visit when `lit` becomes false.
+		std::vector<std::vector<Watcher>> watches;
+
+		// per-variable state
+		std::vector<uint8_t> assigns;
+		std::vector<uint8_t> polarity;
+		std::vector<uint8_t> seen;
+		std::vector<Lit> toClear;
+		std::vector<int> levels;
+		std::vector<uint32_t> reasons;
+		std::vector<uint8_t> model;
+
+		std::vector<Lit> trail;
+		std::vector<size_t> trailLimits;
+		size_t qhead = 0;
+
+		// vsids: a binary max-heap of the variables, ordered by activity.
+		std::vector<double> activity;
+		std::vector<uint32_t> heap;
+		std::vector<int> heapIndex;
+		double varInc = 1;
+		double clauseInc = 1;
+
+		bool aborted = false;
+
+
+		uint8_t value(Lit l) const
+		{
+			auto v = this->assigns[litVar(l)];
+			return v == VAL_UNDEF ? VAL_UNDEF : (v ^ (uint8_t) litNeg(l));
+		}
+
+		int decisionLevel() const { return (int) this->trailLimits.size(); }
+
+		void enqueue(Lit l, uint32_t reason)
+		{
+			auto v = litVar(l);
+			this->assigns[v] = litNeg(l) ? VAL_FALSE : VAL_TRUE;
+			this->levels[v] = this->decisionLevel();
+			this->reasons[v] = reason;
+			this->trail.push_back(l);
+		}
+
+
+		bool heapLess(uint32_t a, uint32_t b) const { return this->activity[a] > this->activity[b]; }
+
+		void heapSwap(size_t i, size_t j)
+		{
+			std::swap(this->heap[i], this->heap[j]);
+			this->heapIndex[this->heap[i]] = (int) i;
+			this->heapIndex[this->heap[j]] = (int) j;
+		}
+
+		void heapUp(size_t i)
+		{
+			while(i > 0 && this->heapLess(this->heap[i], this->heap[(i - 1) / 2]))
+				this->heapSwap(i, (i - 1) / 2), i = (i - 1) / 2;
+		}
+
+		void heapDown(size_t i)
+		{
+			while(true)
+			{
+				size_t l = 2 * i + 1;
+				size_t r = 2 * i + 2;
+				size_t best = i;
+
+				if(l < this->heap.size() && this->heapLess(this->heap[l], this->heap[best])) best = l;
+				if(r < this->heap.size() && this->heapLess(this->heap[r], this->heap[best])) best = r;
+				if(best == i)
+					break;
+
+				this->heapSwap(i, best);
+				i = best;
+			}
+		}
+
+		void heapInsert(uint32_t v)
+		{
+			if(this->heapIndex[v] >= 0)
+				return;
+
+			this->heap.push_back(v);
+			this->heapIndex[v] = (int) this->heap.size() - 1;
+			this->heapUp(this->heap.size() - 1);
+		}
+
+		uint32_t heapPop()
+		{
+			auto top = this->heap[0];
+			this->heapSwap(0, this->heap.size() - 1);
+			this->heap.pop_back();
+			this->heapIndex[top] = -1;
+
+			if(!this->heap.empty())
+				this->heapDown(0);
+
+			return top;
+		}
+
+		void bumpVar(uint32_t v)
+		{
+			if((this->activity[v] += this->varInc) > 1e100)
+			{
+				for(auto& a : this->activity)
+					a *= 1e-100;
+
+				this->varInc *= 1e-100;
+			}
+
+			if(this->heapIndex[v] >= 0)
+				this->heapUp((size_t) this->heapIndex[v]);
+		}
+
+		void bumpClause(Clause& c)
+		{
+			if((c.activity += this->clauseInc) > 1e20)
+			{
+				for(auto& cl : this->clauses)
+					cl.activity *= 1e-20;
+
+				this->clauseInc *= 1e-20;
+			}
+		}
+
+
+		void attach(uint32_t idx)
+		{
+			auto& c = this->clauses[idx];
+			this->watches[c.lits[0]].push_back({ idx, c.lits[1] });
+			this->watches[c.lits[1]].push_back({ idx, c.lits[0] });
+		}
+
+		void cancelUntil(int level)
+		{
+			if(this->decisionLevel() <= level)
+				return;
+
+			for(size_t i = this->trail.size(); i > this->trailLimits[level]; i--)
+			{
+				auto v = litVar(this->trail[i - 1]);
+				this->polarity[v] = this->assigns[v];
+				this->assigns[v] = VAL_UNDEF;
+				this->reasons[v] = NO_REASON;
+				this->heapInsert(v);
+			}
+
+			this->qhead = this->trailLimits[level];
+			this->trail.resize(this->trailLimits[level]);
+			this->trailLimits.resize(level);
+		}
+
+		// returns the conflicting clause, or NO_REASON.
+		uint32_t propagate()
+		{
+			while(this->qhead < this->trail.size())
+			{
+				auto falseLit = negate(this->trail[this->qhead++]);
+				auto& ws = this->watches[falseLit];
+
+				size_t i = 0;
+				size_t j = 0;
+				while(i < ws.size())
+				{
+					auto w = ws[i];
+					if(this->value(w.blocker) == VAL_TRUE)
+					{
+						ws[j++] = ws[i++];
+						continue;
+					}
+
+					// keep the false literal in the second slot
+					auto& c = this->clauses[w.clause];
+					if(c.lits[0] == falseLit)
+						std::swap(c.lits[0], c.lits[1]);
+
+					i++;
+
+					auto first = c.lits[0];
+					if(first != w.blocker && this->value(first) == VAL_TRUE)
+					{
+						ws[j++] = { w.clause, first };
+						continue;
+					}
+
+					bool moved = false;
+					for(size_t k = 2; k < c.lits.size(); k++)
+					{
+						if(this->value(c.lits[k]) != VAL_FALSE)
+						{
+							std::swap(c.lits[1], c.lits[k]);
+							this->watches[c.lits[1]].push_back({ w.clause, first });
+							moved = true;
+							break;
+						}
+					}
+
+					if(moved)
+						continue;
+
+					// the clause is either unit or conflicting.
+					ws[j++] = { w.clause, first };
+					if(this->value(first) == VAL_FALSE)
+					{
+						while(i < ws.size())
+							ws[j++] = ws[i++];
+
+						ws.resize(j);
+						this->qhead = this->trail.size();
+						return w.clause;
+					}
+
+					this->enqueue(first, w.clause);
+				}
+
+				ws.resize(j);
+			}
+
+			return NO_REASON;
+		}
+
+		// a literal is redundant in a learnt clause if everything that implied it is already there.
+		bool redundant(Lit l) const
+		{
+			auto r = this->reasons[litVar(l)];
+			if(r == NO_REASON)
+				return false;
+
+			auto& c = this->clauses[r];
+			for(size_t k = 1; k < c.lits.size(); k++)
+			{
+				auto v = litVar(c.lits[k]);
+				if(!this->seen[v] && this->levels[v] > 0)
+					return false;
+			}
+
+			return true;
+		}
+
+		// first-uip conflict analysis. the asserting literal ends up in out[0].
+		int analyze(uint32_t confl, std::vector<Lit>& out)
+		{
+			out.clear();
+			out.push_back(NO_LIT);
+
+			int pending = 0;
+			Lit p = NO_LIT;
+			size_t index = this->trail.size();
+
+			do {
+				auto& c = this->clauses[confl];
+				if(c.learnt)
+					this->bumpClause(c);
+
+				for(size_t k = (p == NO_LIT ? 0 : 1); k < c.lits.size(); k++)
+				{
+					auto q = c.lits[k];
+					auto v = litVar(q);
+					if(this->seen[v] || this->levels[v] == 0)
+						continue;
+
+					this->bumpVar(v);
+					this->seen[v] = 1;
+
+					if(this->levels[v] >= this->decisionLevel())
+						pending += 1;
+
+					else
+						out.push_back(q);
+				}
+
+				// find the next literal on the trail that's involved in the conflict
+				while(!this->seen[litVar(this->trail[--index])])
+					;
+
+				p = this->trail[index];
+				confl = this->reasons[litVar(p)];
+				this->seen[litVar(p)] = 0;
+				pending -= 1;
+
+			} while(pending > 0);
+
+			out[0] = negate(p);
+
+			// the seen flags of out[1..] are still set, which is what redundant() needs. since
+			// we're about to overwrite the redundant ones, keep them around to clear afterwards.
+			this->toClear.assign(out.begin() + 1, out.end());
+
+			size_t j = 1;
+			for(size_t i = 1; i < out.size(); i++)
+			{
+				if(!this->redundant(out[i]))
+					out[j++] = out[i];
+			}
+
+			for(auto l : this->toClear)
+				this->seen[litVar(l)] = 0;
+
+			out.resize(j);
+
+			// the second watch must be the literal from the highest level, which is where we go back to.
+			int level = 0;
+			if(out.size() > 1)
+			{
+				size_t max = 1;
+				for(size_t i = 2; i < out.size(); i++)
+				{
+					if(this->levels[litVar(out[i])] > this->levels[litVar(out[max])])
+						max = i;
+				}
+
+				std::swap(out[1], out[max]);
+				level = this->levels[litVar(out[1])];
+			}
+
+			return level;
+		}
+
+		// only called at level 0, so none of the learnt clauses can be the reason for anything
+		// that matters (analysis never looks at level-0 reasons). this lets us compact the clause list.
+		void reduceLearnts()
+		{
+			auto learnts = std::vector<uint32_t>();
+			for(uint32_t i = 0; i < this->clauses.size(); i++)
+			{
+				if(this->clauses[i].learnt && this->clauses[i].lits.size() > 2)
+					learnts.push_back(i);
+			}
+
+			std::sort(learnts.begin(), learnts.end(), [this](uint32_t a, uint32_t b) {
+				return this->clauses[a].activity < this->clauses[b].activity;
+			});
+
+			auto dead = std::vector<bool>(this->clauses.size());
+			for(size_t i = 0; i < learnts.size() / 2; i++)
+				dead[learnts[i]] = true;
+
+			size_t j = 0;
+			for(size_t i = 0; i < this->clauses.size(); i++)
+			{
+				if(dead[i])
+					continue;
+
+				if(i != j)
+					this->clauses[j] = std::move(this->clauses[i]);
+
+				j++;
+			}
+
+			this->clauses.resize(j);
+			this->numLearnts -= learnts.size() / 2;
+
+			for(auto& r : this->reasons)
+				r = NO_REASON;
+
+			for(auto& ws : this->watches)
+				ws.clear();
+
+			for(uint32_t i = 0; i < this->clauses.size(); i++)
+				this->attach(i);
+		}
+
+		Lit pickBranch()
+		{
+			while(!this->heap.empty())
+			{
+				auto v = this->heapPop();
+				if(this->assigns[v] == VAL_UNDEF)
+					return mkLit(v, this->polarity[v] != VAL_TRUE);
+			}
+
+			return NO_LIT;
+		}
+
+		int search(int max_conflicts, const std::vector<Lit>& assumptions, const std::function<bool ()>& interrupt,
+			uint64_t& conflicts, uint64_t& decisions)
+		{
+			int local_conflicts = 0;
+			auto learnt = std::vector<Lit>();
+
+			while(true)
+			{
+				if(auto confl = this->propagate(); confl != NO_REASON)
+				{
+					conflicts += 1;
+					local_conflicts += 1;
+
+					if(this->decisionLevel() == 0)
+					{
+						this->ok = false;
+						return Sat::RESULT_UNSAT;
+					}
+
+					auto level = this->analyze(confl, learnt);
+					this->cancelUntil(level);
+
+					if(learnt.size() == 1)
+					{
+						this->enqueue(learnt[0], NO_REASON);
+					}
+					else
+					{
+						auto idx = (uint32_t) this->clauses.size();
+						auto c = Clause();
+						c.lits = learnt;
+						c.learnt = true;
+
+						this->clauses.push_back(std::move(c));
+						this->numLearnts += 1;
+
+						this->attach(idx);
+						this->bumpClause(this->clauses[idx]);
+						this->enqueue(learnt[0], idx);
+					}
+
+					this->varInc /= VAR_DECAY;
+					this->clauseInc /= CLAUSE_DECAY;
+
+					if((conflicts % 1024) == 0 && interrupt && interrupt())
+					{
+						this->aborted = true;
+						return Sat::RESULT_UNKNOWN;
+					}
+				}
+				else
+				{
+					// restart
+					if(local_conflicts >= max_conflicts)
+					{
+						this->cancelUntil(0);
+						return Sat::RESULT_UNKNOWN;
+					}
+
+					if(this->decisionLevel() == 0 && this->numLearnts > this->maxLearnts + this->trail.size())
+					{
+						this->reduceLearnts();
+						this->maxLearnts += this->maxLearnts / 10;
+					}
+
+					Lit next = NO_LIT;
+					while(this->decisionLevel() < (int) assumptions.size())
+					{
+						auto a = assumptions[this->decisionLevel()];
+						if(auto val = this->value(a); val == VAL_TRUE)
+						{
+							// already true; make an empty level so the numbering still lines up.
+							this->trailLimits.push_back(this->trail.size());
+						}
+						else if(val == VAL_FALSE)
+						{
+							return Sat::RESULT_UNSAT;
+						}
+						else
+						{
+							next = a;
+							break;
+						}
+					}
+
+					if(next == NO_LIT)
+					{
+						decisions += 1;
+						next = this->pickBranch();
+
+						if(next == NO_LIT)
+						{
+							this->model = this->assigns;
+							return Sat::RESULT_SAT;
+						}
+					}
+
+					this->trailLimits.push_back(this->trail.size());
+					this->enqueue(next, NO_REASON);
+				}
+			}
+		}
+	};
+
+	// the luby sequence (1, 1, 2, 1, 1, 2, 4, ...), for restart intervals.
+	static double luby(double y, int x)
+	{
+		int size = 1;
+		int seq = 0;
+		while(size < x + 1)
+			seq++, size = 2 * size + 1;
+
+		while(size - 1 != x)
+		{
+			size = (size - 1) >> 1;
+			seq--;
+			x = x % size;
+		}
+
+		return pow(y, seq);
+	}
+
+
+
+	Sat::Sat() : state(new SatState()) { }
+	Sat::~Sat() { delete this->state; }
+
+	size_t Sat::numVars() const
+	{
+		return this->state->assigns.size();
+	}
+
+	size_t Sat::memoryUsage() const
+	{
+		auto st = this->state;
+		auto ret = sizeof(SatState);
+		for(auto& c : st->clauses)
+			ret += sizeof(Clause) + c.lits.size() * sizeof(Lit);
+
+		for(auto& w : st->watches)
+			ret += sizeof(w) + w.size() * sizeof(Watcher);
+
+		// assigns, polarity, seen, levels, reasons, model, activity, heap, heapIndex; the trail
+		// is at most one per variable too.
+		ret += st->assigns.size() * (4 * sizeof(uint8_t) + sizeof(int) + 2 * sizeof(uint32_t)
+			+ sizeof(double) + sizeof(int) + sizeof(Lit));
+
+		return ret;
+	}
+
+	uint32_t Sat::newVar()
+	{
+		auto s = this->state;
+		auto v = (uint32_t) s->assigns.size();
+
+		s->assigns.push_back(VAL_UNDEF);
+		s->polarity.push_back(VAL_FALSE);
+		s->seen.push_back(0);
+		s->levels.push_back(0);
+		s->reasons.push_back(NO_REASON);
+		s->activity.push_back(0);
+		s->heapIndex.push_back(-1);
+		s->watches.emplace_back();
+		s->watches.emplace_back();
+
+		s->heapInsert(v);
+		return v;
+	}
+
+	bool Sat::addClause(std::vector<Lit> lits)
+	{
+		auto s = this->state;
+		if(!s->ok)
+			return false;
+
+		// clauses are only ever added between searches, at level 0.
+		assert(s->decisionLevel() == 0);
+
+		// complementary literals are adjacent after sorting.
+		std::sort(lits.begin(), lits.end());
+
+		size_t j = 0;
+		for(size_t i = 0; i < lits.size(); i++)
+		{
+			auto val = s->value(lits[i]);
+			if(val == VAL_TRUE || (i > 0 && lits[i] == negate(lits[i - 1])))
+				return true;
+
+			if(val == VAL_FALSE || (j > 0 && lits[j - 1] == lits[i]))
+				continue;
+
+			lits[j++] = lits[i];
+		}
+
+		lits.resize(j);
+
+		if(lits.empty())
+		{
+			s->ok = false;
+		}
+		else if(lits.size() == 1)
+		{
+			s->enqueue(lits[0], NO_REASON);
+			s->ok = (s->propagate() == NO_REASON);
+		}
+		else
+		{
+			auto c = Clause();
+			c.lits = std::move(lits);
+
+			s->clauses.push_back(std::move(c));
+			s->attach((uint32_t) s->clauses.size() - 1);
+		}
+
+		return s->ok;
+	}
+
+	int Sat::solve(const std::vector<Lit>& assumptions)
+	{
+		auto s = this->state;
+		if(!s->ok)
+			return RESULT_UNSAT;
+
+		s->aborted = false;
+		s->maxLearnts = std::max((size_t) 5000, s->clauses.size() / 3);
+
+		int result = RESULT_UNKNOWN;
+		for(int restarts = 0; result == RESULT_UNKNOWN; restarts++)
+		{
+			if(this->interrupt && this->interrupt())
+				break;
+
+			auto budget = (int) (luby(2, restarts) * RESTART_BASE);
+			result = s->search(budget, assumptions, this->interrupt, this->conflicts, this->decisions);
+
+			if(s->aborted)
+				break;
+		}
+
+		s->cancelUntil(0);
+		return result;
+	}
+
+	bool Sat::modelValue(uint32_t var) const
+	{
+		return this->state->model[var] == VAL_TRUE;
+	}
+}
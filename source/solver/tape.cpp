@@ -0,0 +1,108 @@
+// tape.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "ast.h"
+#include "solver.h"
+
+namespace solver
+{
+	// lane j of block b is assignment 64b + j, so variable k (for k < 6) is just bit k of j.
+	static constexpr uint64_t LANE_PATTERNS[6] = {
+		0xAAAA'AAAA'AAAA'AAAA,
+		0xCCCC'CCCC'CCCC'CCCC,
+		0xF0F0'F0F0'F0F0'F0F0,
+		0xFF00'FF00'FF00'FF00,
+		0xFFFF'0000'FFFF'0000,
+		0xFFFF'FFFF'0000'0000,
+	};
+
+	static uint32_t emit(Tape& tape, const Tape::Op& op)
+	{
+		tape.ops.push_back(op);
+		return (uint32_t) (tape.ops.size() - 1);
+	}
+
+	static uint32_t compile_expr(Tape& tape, const ast::Expr* expr,
+		const std::unordered_map<std::string, uint32_t>& indices)
+	{
+		if(auto l = dynamic_cast<const ast::Lit*>(expr); l != nullptr)
+		{
+			return emit(tape, { Tape::OP_CONST, l->value ? 1u : 0u, 0 });
+		}
+		else if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			auto it = indices.find(v->name);
+			if(it == indices.end())
+				lg::fatal("solver", "variable '{}' missing from the variable list", v->name);
+
+			return emit(tape, { Tape::OP_VAR, it->second, 0 });
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			auto e = compile_expr(tape, n->e, indices);
+			return emit(tape, { Tape::OP_NOT, e, 0 });
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			auto l = compile_expr(tape, a->left, indices);
+			auto r = compile_expr(tape, a->right, indices);
+			return emit(tape, { Tape::OP_AND, l, r });
+		}
+		else
+		{
+			lg::fatal("solver", "invalid expression");
+		}
+	}
+
+	Tape Tape::compile(const ast::Expr* expr, const std::vector<std::string>& vars)
+	{
+		std::unordered_map<std::string, uint32_t> indices;
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = (uint32_t) i;
+
+		auto tape = Tape();
+		tape.numVars = vars.size();
+		compile_expr(tape, expr, indices);
+
+		return tape;
+	}
+
+	uint64_t Tape::run(const uint64_t* vars, uint64_t* slots) const
+	{
+		size_t n = this->ops.size();
+		for(size_t i = 0; i < n; i++)
+		{
+			auto& op = this->ops[i];
+			switch(op.kind)
+			{
+				case OP_VAR:    slots[i] = vars[op.a]; break;
+				case OP_CONST:  slots[i] = op.a ? ~0ULL : 0; break;
+				case OP_AND:    slots[i] = slots[op.a] & slots[op.b]; break;
+				case OP_NOT:    slots[i] = ~slots[op.a]; break;
+			}
+		}
+
+		return slots[n - 1];
+	}
+
+	uint64_t Tape::numBlocks(size_t num_vars)
+	{
+		return num_vars <= 6 ? 1 : (1ULL << (num_vars - 6));
+	}
+
+	uint64_t Tape::laneMask(size_t num_vars)
+	{
+		// with fewer than 6 variables, only the first 2^n lanes are real assignments.
+		return num_vars >= 6 ? ~0ULL : ((1ULL << (1ULL << num_vars)) - 1);
+	}
+
+	void Tape::loadBlock(uint64_t* vars, size_t num_vars, uint64_t block)
+	{
+		for(size_t k = 0; k < num_vars; k++)
+		{
+			if(k < 6)   vars[k] = LANE_PATTERNS[k];
+			else        vars[k] = ((block >> (k - 6)) & 1) ? ~0ULL : 0;
+		}
+	}
+}
@@ -0,0 +1,266 @@
+// main.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+// checks the solver engines against the brute-force cursor; build and run with `make solver-test`.
+
+#include <cstdio>
+#include <random>
+
+#include "ast.h"
+#include "solver.h"
+
+namespace alpha
+{
+	// util/solver.cpp
+	solver::Cursor* make_brute_force_solver(ast::Expr* expr, const std::vector<std::string>& vars, bool parallel,
+		const solver::PartialAssignment& pins);
+
+	solver::Cursor* make_gray_code_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins);
+
+	solver::Cursor* make_sat_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins);
+
+	solver::Cursor* make_bdd_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, solver::Job& job);
+
+	int step_solver(solver::Cursor* cursor, bool forward, solver::Job& job);
+
+	bool count_models(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::BigNum* out, solver::Job& job);
+
+	bool approx_count(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		double epsilon, double delta, solver::BigNum* out, bool* exact, solver::Job& job);
+
+	int find_counterexample(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::PartialAssignment* out, solver::Job& job);
+
+	int check_equivalent(ast::Expr* a, ast::Expr* b, const std::vector<std::string>& vars,
+		solver::PartialAssignment* out, solver::Job& job);
+}
+
+static int failures = 0;
+
+#define CHECK(x) do { if(!(x)) { failures++; printf("failed: %s (line %d)\n", #x, __LINE__); } } while(0)
+
+static std::mt19937_64 rng(1);
+
+static std::vector<std::string> make_vars(size_t n)
+{
+	auto ret = std::vector<std::string>();
+	for(size_t i = 0; i < n; i++)
+		ret.push_back(zpr::sprint("x{}", i));
+
+	return ret;
+}
+
+static ast::Expr* random_expr(const std::vector<std::string>& vars, int depth)
+{
+	auto k = rng() % 4;
+	if(depth == 0 || k == 0)
+		return new ast::Var(vars[rng() % vars.size()]);
+
+	if(k == 1)
+		return new ast::Not(random_expr(vars, depth - 1));
+
+	return new ast::And(random_expr(vars, depth - 1), random_expr(vars, depth - 1));
+}
+
+static bool is_solution(ast::Expr* expr, const std::vector<std::string>& vars, const solver::Assignment& values)
+{
+	auto syms = std::unordered_map<std::string, bool>();
+	for(size_t i = 0; i < vars.size(); i++)
+		syms[vars[i]] = values.get(i);
+
+	auto r = expr->evaluate(syms);
+	auto l = dynamic_cast<ast::Lit*>(r);
+
+	bool ret = (l != nullptr && l->value);
+	delete r;
+
+	return ret;
+}
+
+// every solution, in the order the cursor finds them; takes ownership of the cursor.
+static std::vector<solver::Assignment> all_solutions(solver::Cursor* cursor)
+{
+	auto job = solver::Job();
+	auto ret = std::vector<solver::Assignment>();
+	while(alpha::step_solver(cursor, /* forward: */ true, job) == solver::Cursor::STEP_FOUND)
+		ret.push_back(cursor->values());
+
+	delete cursor;
+	return ret;
+}
+
+static bool same_set(std::vector<solver::Assignment> a, std::vector<solver::Assignment> b)
+{
+	auto less = [](const solver::Assignment& x, const solver::Assignment& y) { return x.words < y.words; };
+	std::sort(a.begin(), a.end(), less);
+	std::sort(b.begin(), b.end(), less);
+
+	return a == b;
+}
+
+static void test_engines()
+{
+	auto job = solver::Job();
+	auto none = solver::PartialAssignment();
+
+	for(int i = 0; i < 200; i++)
+	{
+		auto vars = make_vars(2 + rng() % 9);
+		auto expr = random_expr(vars, 2 + (int) (rng() % 5));
+
+		auto expected = all_solutions(alpha::make_brute_force_solver(expr, vars, /* parallel: */ false, none));
+		for(auto& s : expected)
+			CHECK(is_solution(expr, vars, s));
+
+		CHECK(all_solutions(alpha::make_brute_force_solver(expr, vars, /* parallel: */ true, none)) == expected);
+		CHECK(same_set(all_solutions(alpha::make_gray_code_solver(expr, vars, none)), expected));
+		CHECK(same_set(all_solutions(alpha::make_sat_solver(expr, vars, none)), expected));
+		CHECK(same_set(all_solutions(alpha::make_bdd_solver(expr, vars, none, job)), expected));
+
+		auto count = solver::BigNum();
+		CHECK(alpha::count_models(expr, vars, none, &count, job));
+		CHECK(count == solver::BigNum(expected.size()));
+
+		// at this epsilon it counts exactly up to ~1300 solutions, and 10 variables can't have more than 1024.
+		auto estimate = solver::BigNum();
+		bool exact = false;
+		CHECK(alpha::approx_count(expr, vars, none, 0.1, 0.2, &estimate, &exact, job));
+		CHECK(exact && estimate == count);
+
+		auto counterexample = solver::PartialAssignment();
+		auto valid = alpha::find_counterexample(expr, vars, none, &counterexample, job);
+		CHECK((valid == solver::Cursor::STEP_END) == (expected.size() == (1ULL << vars.size())));
+		if(valid == solver::Cursor::STEP_FOUND)
+			CHECK(!is_solution(expr, vars, counterexample.values));
+
+		// an expression is the same as its double cut, and different from itself with one more variable
+		// pinned, unless that doesn't lose any solutions.
+		auto copy = random_expr(vars, 0);
+		auto doubled = ast::Not(new ast::Not(expr));
+		auto narrowed = ast::And(expr, copy);
+
+		auto witness = solver::PartialAssignment();
+		CHECK(alpha::check_equivalent(expr, &doubled, vars, &witness, job) == solver::EQUIV_SAME);
+
+		auto narrowed_count = all_solutions(alpha::make_brute_force_solver(&narrowed, vars, false, none)).size();
+		auto result = alpha::check_equivalent(expr, &narrowed, vars, &witness, job);
+		CHECK((result == solver::EQUIV_SAME) == (narrowed_count == expected.size()));
+		if(result == solver::EQUIV_DIFFERENT)
+			CHECK(is_solution(expr, vars, witness.values) != is_solution(&narrowed, vars, witness.values));
+
+		// the stack ones don't own what they point at.
+		static_cast<ast::Not*>(doubled.e)->e = nullptr;
+		narrowed.left = nullptr;
+
+		delete expr;
+	}
+}
+
+static void test_checkpoint()
+{
+	auto job = solver::Job();
+	auto none = solver::PartialAssignment();
+	auto path = std::string("solver-test.search");
+
+	for(int i = 0; i < 50; i++)
+	{
+		auto vars = make_vars(4 + rng() % 8);
+		auto expr = random_expr(vars, 4);
+
+		auto expected = all_solutions(alpha::make_brute_force_solver(expr, vars, false, none));
+		auto stop = expected.empty() ? 0 : rng() % expected.size();
+
+		auto cursor = alpha::make_brute_force_solver(expr, vars, false, none);
+		for(size_t k = 0; k < stop; k++)
+			alpha::step_solver(cursor, /* forward: */ true, job);
+
+		auto search = solver::SavedSearch();
+		search.key = zpr::sprint("test {}", i);
+		search.engine = 7;
+		search.pins = solver::PartialAssignment(vars.size());
+		CHECK(cursor->save(&search.cursor));
+		CHECK(solver::writeSavedSearch(path, search));
+		delete cursor;
+
+		auto back = solver::SavedSearch();
+		CHECK(solver::readSavedSearch(path, &back));
+		CHECK(back.key == search.key && back.engine == search.engine && back.pins == search.pins);
+
+		// a fresh cursor picks up where the old one was, and finds the rest.
+		cursor = alpha::make_brute_force_solver(expr, vars, false, none);
+		CHECK(cursor->resume(back.cursor));
+
+		auto rest = std::vector<solver::Assignment>();
+		if(stop > 0)
+			rest.push_back(cursor->values());
+
+		auto more = all_solutions(cursor);
+		rest.insert(rest.end(), more.begin(), more.end());
+
+		CHECK(rest == std::vector<solver::Assignment>(expected.begin() + (long) (stop > 0 ? stop - 1 : 0), expected.end()));
+		delete expr;
+	}
+
+	std::remove(path.c_str());
+}
+
+static std::string u128_str(unsigned __int128 x)
+{
+	auto ret = std::string();
+	do {
+		ret.insert(ret.begin(), (char) ('0' + (int) (x % 10)));
+		x /= 10;
+	} while(x > 0);
+
+	return ret;
+}
+
+static void test_bignum()
+{
+	for(int i = 0; i < 10000; i++)
+	{
+		uint64_t a = rng() >> (rng() % 64);
+		uint64_t b = rng() >> (rng() % 64);
+		auto shift = (size_t) (rng() % 60);
+
+		auto x = solver::BigNum(a);
+		auto y = solver::BigNum(b);
+
+		CHECK((x + y).str() == u128_str((unsigned __int128) a + b));
+		CHECK((x * y).str() == u128_str((unsigned __int128) a * b));
+		CHECK((x << shift).str() == u128_str((unsigned __int128) a << shift));
+		CHECK((x < y) == (a < b));
+
+		if(a >= b)
+			CHECK((x - y) == solver::BigNum(a - b));
+
+		CHECK((x * y + x) - x == x * y);
+	}
+
+	// 2^200 - 1 is 200 ones, and (2^100)^2 is 2^200.
+	auto big = (solver::BigNum(1) << 200) - solver::BigNum(1);
+	CHECK(big + solver::BigNum(1) == (solver::BigNum(1) << 100) * (solver::BigNum(1) << 100));
+	CHECK(big.str() == "1606938044258990275541962092341162602522202993782792835301375");
+	CHECK(solver::BigNum(0).isZero() && solver::BigNum(0).str() == "0");
+}
+
+int main()
+{
+	test_engines();
+	test_checkpoint();
+	test_bignum();
+
+	if(failures > 0)
+	{
+		printf("%d check%s failed\n", failures, failures == 1 ? "" : "s");
+		return 1;
+	}
+
+	printf("all ok\n");
+	return 0;
+}
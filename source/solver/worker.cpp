@@ -0,0 +1,434 @@
+// worker.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include "solver.h"
+
+#if !defined(__EMSCRIPTEN__)
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+
+namespace solver
+{
+	static constexpr uint64_t MSG_TAPE = 1;     // num vars, num ops, then (kind, a | b << 32) for each op
+	static constexpr uint64_t MSG_SCAN = 2;     // first, forward, begin, end, first mask; replies with the hit
+
+	// the socket ends up as this fd in the worker.
+	static constexpr int WORKER_FD = 3;
+
+	// how long to wait for the workers before checking whether we should give up.
+	static constexpr int POLL_TIMEOUT_MS = 50;
+
+	// nothing that we could brute-force would need a tape anywhere near this long.
+	static constexpr uint64_t MAX_TAPE_OPS = 1ULL << 28;
+
+	// a worker that's gone away shouldn't take us with it (by SIGPIPE).
+	#if defined(MSG_NOSIGNAL)
+		static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+	#else
+		static constexpr int SEND_FLAGS = 0;
+	#endif
+
+	static bool send_words(int fd, const uint64_t* words, size_t n)
+	{
+		auto p = reinterpret_cast<const char*>(words);
+		auto left = n * sizeof(uint64_t);
+		while(left > 0)
+		{
+			auto k = ::send(fd, p, left, SEND_FLAGS);
+			if(k < 0 && errno == EINTR)
+				continue;
+
+			if(k <= 0)
+				return false;
+
+			p += k;
+			left -= (size_t) k;
+		}
+
+		return true;
+	}
+
+	static bool recv_words(int fd, uint64_t* words, size_t n)
+	{
+		auto p = reinterpret_cast<char*>(words);
+		auto left = n * sizeof(uint64_t);
+		while(left > 0)
+		{
+			auto k = ::recv(fd, p, left, 0);
+			if(k < 0 && errno == EINTR)
+				continue;
+
+			if(k <= 0)
+				return false;
+
+			p += k;
+			left -= (size_t) k;
+		}
+
+		return true;
+	}
+
+	WorkerPool::WorkerPool(std::string prog, size_t num_workers) : program(std::move(prog)),
+		workers(std::max((size_t) 1, num_workers))
+	{
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		// closing the socket is how the workers know to stop.
+		for(auto& w : this->workers)
+		{
+			if(w.fd >= 0)
+				::close(w.fd);
+		}
+
+		for(auto& w : this->workers)
+		{
+			if(w.pid > 0)
+				::waitpid(w.pid, nullptr, 0);
+		}
+	}
+
+	bool WorkerPool::spawn(Worker& w)
+	{
+		int sv[2];
+		if(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+			return false;
+
+		// neither end should leak into the other workers, or they'd never see the socket close.
+		::fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+		::fcntl(sv[1], F_SETFD, FD_CLOEXEC);
+
+		#if defined(SO_NOSIGPIPE)
+			int one = 1;
+			::setsockopt(sv[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+		#endif
+
+		// the child can't allocate (another thread might have been holding the malloc lock), so
+		// everything it needs has to be ready before the fork.
+		auto fd_arg = std::to_string(WORKER_FD);
+		char* argv[] = {
+			const_cast<char*>(this->program.c_str()),
+			const_cast<char*>("--solver-worker"),
+			const_cast<char*>(fd_arg.c_str()),
+			nullptr
+		};
+
+		auto pid = ::fork();
+		if(pid < 0)
+		{
+			::close(sv[0]);
+			::close(sv[1]);
+			return false;
+		}
+
+		if(pid == 0)
+		{
+			// dup2 clears close-on-exec, unless it's already the right fd.
+			if(sv[1] == WORKER_FD)
+				::fcntl(WORKER_FD, F_SETFD, 0);
+			else
+				::dup2(sv[1], WORKER_FD);
+
+			::execvp(argv[0], argv);
+			::_exit(127);
+		}
+
+		::close(sv[1]);
+
+		w = Worker();
+		w.pid = pid;
+		w.fd = sv[0];
+		return true;
+	}
+
+	void WorkerPool::kill(Worker& w)
+	{
+		if(w.fd >= 0)
+			::close(w.fd);
+
+		if(w.pid > 0)
+		{
+			::kill(w.pid, SIGKILL);
+			::waitpid(w.pid, nullptr, 0);
+		}
+
+		w = Worker();
+	}
+
+	bool WorkerPool::send(Worker& w, uint64_t tape_id, const Tape& tape, const Scan& scan, uint64_t chunk)
+	{
+		if(w.tapeId != tape_id)
+		{
+			auto words = std::vector<uint64_t>({ MSG_TAPE, tape.numVars, tape.ops.size() });
+			for(auto& op : tape.ops)
+			{
+				words.push_back(op.kind);
+				words.push_back(op.a | ((uint64_t) op.b << 32));
+			}
+
+			if(!send_words(w.fd, words.data(), words.size()))
+				return false;
+
+			w.tapeId = tape_id;
+		}
+
+		auto begin = scan.begin + chunk * scan.chunk;
+		auto end = std::min(scan.end, begin + scan.chunk);
+
+		uint64_t msg[] = { MSG_SCAN, scan.first, scan.forward, begin, end, scan.firstMask };
+		return send_words(w.fd, msg, sizeof(msg) / sizeof(msg[0]));
+	}
+
+	bool WorkerPool::scan(uint64_t tape_id, const Tape& tape, const Scan& scan, uint64_t* best,
+		const std::function<bool ()>& interrupt, const std::function<void (uint64_t)>& done)
+	{
+		auto lk = std::lock_guard(this->lock);
+
+		// bring back the ones that died since last time.
+		for(auto& w : this->workers)
+		{
+			if(w.fd < 0 && !this->spawn(w))
+				lg::warn("solver", "could not start a solver process");
+		}
+
+		*best = UINT64_MAX;
+
+		auto chunks = (scan.end - scan.begin + scan.chunk - 1) / scan.chunk;
+		uint64_t next = 0;
+
+		// the chunks that were with a worker when it died.
+		auto retry = std::vector<uint64_t>();
+
+		bool stopped = false;
+		size_t busy = 0;
+
+		// once something turns up, only the chunks before it still matter.
+		auto wanted = [&](uint64_t chunk) -> bool {
+			return scan.begin + chunk * scan.chunk <= *best;
+		};
+
+		auto take = [&](uint64_t* out) -> bool {
+			while(!retry.empty())
+			{
+				auto c = retry.back();
+				retry.pop_back();
+
+				if(wanted(c))
+				{
+					*out = c;
+					return true;
+				}
+			}
+
+			if(next < chunks && wanted(next))
+			{
+				*out = next++;
+				return true;
+			}
+
+			return false;
+		};
+
+		while(true)
+		{
+			for(auto& w : this->workers)
+			{
+				uint64_t chunk = 0;
+				if(w.fd < 0 || w.busy || stopped || !take(&chunk))
+					continue;
+
+				if(!this->send(w, tape_id, tape, scan, chunk))
+				{
+					this->kill(w);
+					retry.push_back(chunk);
+					continue;
+				}
+
+				w.busy = true;
+				w.chunk = chunk;
+				busy++;
+			}
+
+			if(busy == 0)
+			{
+				if(stopped)
+					return false;
+
+				uint64_t chunk = 0;
+				if(!take(&chunk))
+					break;
+
+				// there's still work, but nobody to do it.
+				lg::error("solver", "all of the solver processes died");
+				return false;
+			}
+
+			auto fds = std::vector<pollfd>();
+			auto which = std::vector<Worker*>();
+			for(auto& w : this->workers)
+			{
+				if(w.busy)
+				{
+					fds.push_back({ w.fd, POLLIN, 0 });
+					which.push_back(&w);
+				}
+			}
+
+			::poll(fds.data(), fds.size(), POLL_TIMEOUT_MS);
+
+			// stop handing things out, but let the ones that are busy finish, so that nothing old is
+			// left on the sockets for the next scan.
+			if(!stopped && interrupt && interrupt())
+				stopped = true;
+
+			for(size_t i = 0; i < fds.size(); i++)
+			{
+				if(fds[i].revents == 0)
+					continue;
+
+				auto& w = *which[i];
+				auto chunk = w.chunk;
+
+				busy--;
+				w.busy = false;
+
+				uint64_t hit = 0;
+				if(!recv_words(w.fd, &hit, 1))
+				{
+					lg::warn("solver", "solver process {} died", w.pid);
+					this->kill(w);
+					retry.push_back(chunk);
+					continue;
+				}
+
+				if(hit != UINT64_MAX)
+					*best = std::min(*best, hit);
+
+				if(done)
+				{
+					auto begin = scan.begin + chunk * scan.chunk;
+					done(std::min(scan.end, begin + scan.chunk) - begin);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// the first i in [begin, end) where block first + i (or first - i) has a solution.
+	static uint64_t scan_blocks(const Tape& tape, uint64_t first, bool fwd, uint64_t begin, uint64_t end,
+		uint64_t first_mask, std::vector<uint64_t>& inputs, std::vector<uint64_t>& slots)
+	{
+		auto lanes = Tape::laneMask(tape.numVars);
+		for(auto i = begin; i < end; i++)
+		{
+			auto b = fwd ? first + i : first - i;
+			Tape::loadBlock(inputs.data(), tape.numVars, b);
+
+			if(tape.run(inputs.data(), slots.data()) & (i == 0 ? first_mask : lanes))
+				return i;
+		}
+
+		return UINT64_MAX;
+	}
+
+	// operands have to come before the op that uses them.
+	static bool valid_op(const Tape& tape, const Tape::Op& op, size_t index)
+	{
+		switch(op.kind)
+		{
+			case Tape::OP_VAR:      return op.a < tape.numVars;
+			case Tape::OP_CONST:    return true;
+			case Tape::OP_AND:      return op.a < index && op.b < index;
+			case Tape::OP_NOT:      return op.a < index;
+			default:                return false;
+		}
+	}
+
+	int runWorker(int fd)
+	{
+		auto tape = Tape();
+		auto inputs = std::vector<uint64_t>();
+		auto slots = std::vector<uint64_t>();
+
+		while(true)
+		{
+			uint64_t kind = 0;
+			if(!recv_words(fd, &kind, 1))
+				return 0;
+
+			if(kind == MSG_TAPE)
+			{
+				uint64_t header[2];
+				if(!recv_words(fd, header, 2) || header[0] > 64 || header[1] == 0 || header[1] > MAX_TAPE_OPS)
+					return 1;
+
+				auto words = std::vector<uint64_t>(2 * header[1]);
+				if(!recv_words(fd, words.data(), words.size()))
+					return 1;
+
+				tape = Tape();
+				tape.numVars = header[0];
+				for(size_t i = 0; i < header[1]; i++)
+				{
+					auto op = Tape::Op { (uint8_t) words[2 * i], (uint32_t) words[2 * i + 1],
+						(uint32_t) (words[2 * i + 1] >> 32) };
+
+					if(!valid_op(tape, op, i))
+						return 1;
+
+					tape.ops.push_back(op);
+				}
+
+				inputs.resize(tape.numVars);
+				slots.resize(tape.ops.size());
+			}
+			else if(kind == MSG_SCAN)
+			{
+				uint64_t args[5];
+				if(!recv_words(fd, args, 5) || tape.ops.empty())
+					return 1;
+
+				auto hit = scan_blocks(tape, args[0], args[1] != 0, args[2], args[3], args[4], inputs, slots);
+				if(!send_words(fd, &hit, 1))
+					return 0;
+			}
+			else
+			{
+				return 1;
+			}
+		}
+	}
+}
+
+#else
+
+namespace solver
+{
+	// there's no fork() on the web.
+	WorkerPool::WorkerPool(std::string prog, size_t num_workers) : program(std::move(prog)), workers(1) { }
+	WorkerPool::~WorkerPool() { }
+
+	bool WorkerPool::scan(uint64_t tape_id, const Tape& tape, const Scan& scan, uint64_t* best,
+		const std::function<bool ()>& interrupt, const std::function<void (uint64_t)>& done)
+	{
+		lg::error("solver", "solver processes are not supported here");
+		return false;
+	}
+
+	int runWorker(int fd)
+	{
+		return 1;
+	}
+}
+
+#endif
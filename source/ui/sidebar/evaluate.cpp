@@ -2,246 +2,180 @@
 // Copyright (c) 2021, zhiayang
 // Licensed under the Apache License Version 2.0.
 
-#include <thread>
+#include <unordered_set>
 
 #include "ui.h"
 #include "ast.h"
 #include "alpha.h"
+#include "solver.h"
 #include "imgui/imgui.h"
 
 namespace imgui = ImGui;
 using namespace alpha;
 
-namespace alpha
-{
-	// util/solver.cpp
-	std::vector<std::unordered_map<std::string, bool>>
-	generate_solutions(ast::Expr* expr, const std::set<std::string>& vars,
-		std::pair<size_t, size_t>& progress);
-
-	void abort_solve();
-}
-
 namespace ui
 {
 	// defined in exprbar.cpp
 	ast::Expr* get_cached_expr(Graph* graph);
 	std::string expr_to_string(ast::Expr* expr);
 
-	Styler flash_style(int button);
-	Styler disabled_style(bool disabled);
 	Styler toggle_enabled_style(bool enabled);
 
-	static void find_variables(ast::Expr* expr);
-	static int get_var_state(const std::unordered_map<std::string, bool>& vars, const std::string& name);
+	// sidebar/solve.cpp
+	void solver_tool(Graph* graph);
+	void pause_solving();
+	void reset_soln(bool keep_jobs = false);
+	bool restore_soln(Graph* graph, const solver::PartialAssignment& pins);
+	void look_for_saved_search(Graph* graph, const solver::PartialAssignment& pins);
+	const solver::PartialAssignment& user_pins();
+	void forget_optimum();
 
-	static void solver_tool(Graph* graph);
+	void set_flags(Graph* graph, const solver::PartialAssignment& soln);
+
+	void find_variables(ast::Expr* expr, std::set<std::string>& vars);
+	void refresh_assignments(Graph* graph, bool everything);
+
+	static void find_variable_items(Graph* graph);
+	static int get_var_state(const solver::PartialAssignment& vars, size_t idx);
 	static void variable_assign_tool(Graph* graph);
 
+	// variables are numbered by their place in foundVariables (which is sorted); names only matter when drawing.
 	static bool vars_updated = false;
-	static std::set<std::string> foundVariables;
-	static std::unordered_map<std::string, bool> varAssigns;
-
-	static bool solve_requested = false;
-	static volatile bool solver_done = true;
-	static std::pair<size_t, size_t> solver_progress;
-	static struct {
-		size_t index = 0;
-		bool waiting = false;
-		bool did_solve = false;
-		std::vector<std::unordered_map<std::string, bool>> solns;
-	} solver_state;
-
-	void set_flags(Graph* graph, const std::unordered_map<std::string, bool>& soln);
-
-	static void reset_soln()
-	{
-		solver_done = true;
-		solver_state.solns.clear();
-		solver_state.did_solve = false;
-		solver_state.waiting = false;
-	}
+	static std::vector<std::string> foundVariables;
+	static std::unordered_map<std::string, size_t> variableIndices;
+	static solver::PartialAssignment varAssigns;
 
-	// called when the mode changes
-	void evalModeChanged(Graph* graph, bool active)
+	// for optimising; these go by name, so they stick around when the variables change.
+	static std::unordered_map<std::string, int64_t> variableWeights;
+
+	// the variables that solving doesn't care about; each solution is then a different combination
+	// of only the others. these also go by name.
+	static std::unordered_set<std::string> hiddenVariables;
+
+	// for re-evaluating only what a change in assignments affects; see refresh_assignments().
+	static solver::Evaluator evaluator;
+	static std::vector<std::vector<Item*>> variableItems;
+	static bool evaluator_stale = true;
+
+	// used by sidebar/solve.cpp
+	const std::vector<std::string>& found_variables() { return foundVariables; }
+	solver::PartialAssignment& var_assigns() { return varAssigns; }
+
+	// which of foundVariables aren't hidden; empty if none of them are.
+	std::vector<bool> current_projection()
 	{
-		if(!active)
+		auto ret = std::vector<bool>(foundVariables.size(), true);
+
+		bool any = false;
+		for(size_t n = 0; n < foundVariables.size(); n++)
 		{
-			ui::resetEvalExpr();
-			set_flags(graph, { });
-			alpha::abort_solve();
+			if(hiddenVariables.count(foundVariables[n]) > 0)
+			{
+				ret[n] = false;
+				any = true;
+			}
 		}
+
+		return any ? ret : std::vector<bool>();
 	}
 
-	void rescan_variables(Graph* graph)
+	// ast::Expr::evaluate still goes by name.
+	static std::unordered_map<std::string, bool> to_symbols(const solver::PartialAssignment& assigns)
 	{
-		if((graph->flags & FLAG_GRAPH_MODIFIED) || foundVariables.empty())
+		auto ret = std::unordered_map<std::string, bool>();
+		for(size_t i = 0; i < assigns.size(); i++)
 		{
-			reset_soln();
-			foundVariables.clear();
-			find_variables(get_cached_expr(graph));
+			if(assigns.isAssigned(i))
+				ret[foundVariables[i]] = assigns.get(i);
 		}
+
+		return ret;
 	}
 
-	void eval_tools(Graph* graph)
+	// most of the time the assignment decides the result, so we only need to build the
+	// simplified expression when it doesn't.
+	static std::string result_string(ast::Expr* expr)
 	{
-		imgui::PushID("__scope_eval");
-
-		solver_tool(graph);
-		imgui::NewLine();
+		if(auto val = evaluator.result(); val != ast::TRI_UNKNOWN)
+			return val == ast::TRI_TRUE ? "1" : "0";
 
-		variable_assign_tool(graph);
+		auto residual = expr->evaluate(to_symbols(varAssigns));
+		auto ret = expr_to_string(residual);
 
-		imgui::PopID();
+		delete residual;
+		return ret;
 	}
 
+	int64_t weight_of(const std::string& var)
+	{
+		if(auto it = variableWeights.find(var); it != variableWeights.end())
+			return it->second;
 
+		return 1;
+	}
 
-	static void solver_tool(Graph* graph)
+	// called when the mode changes
+	void evalModeChanged(Graph* graph, bool active)
 	{
-		auto& theme = ui::theme();
-
-		imgui::PushID("__scope_solve");
+		if(!active)
+		{
+			ui::resetEvalExpr();
+			set_flags(graph, solver::PartialAssignment());
 
-		imgui::Text("solver");
-		imgui::Indent();
+			pause_solving();
+		}
+	}
 
-		// tasks
+	void rescan_variables(Graph* graph)
+	{
+		if((graph->flags & FLAG_GRAPH_MODIFIED) || foundVariables.empty())
 		{
-			auto done = __atomic_load_n(&solver_done, __ATOMIC_SEQ_CST);
-			{
-				auto s = disabled_style(done == false || foundVariables.size() > 32);
-				auto ss = flash_style(SB_BUTTON_V_SOLVE);
-				if((imgui::Button("s \uf0ae solve ") || solve_requested) && done)
-				{
-					solve_requested = false;
-
-					__atomic_store_n(&solver_done, false, __ATOMIC_SEQ_CST);
-					if(auto sz = foundVariables.size(); sz >= 16)
-						ui::logMessage(zpr::sprint("solving {} variables; this might take some time...", sz), 3);
+			// a solution for the old graph means nothing for the new one, so go back to the
+			// variables that the user pinned.
+			auto old_assigns = user_pins();
+			reset_soln();
 
-					solver_state.waiting = true;
-					solver_state.did_solve = true;
-					auto t = std::thread([](ast::Expr* expr) {
-						solver_state.solns = alpha::generate_solutions(expr,
-							foundVariables, solver_progress);
+			auto expr = get_cached_expr(graph);
+			auto vars = std::set<std::string>();
+			find_variables(expr, vars);
 
-						__atomic_store_n(&solver_done, true, __ATOMIC_SEQ_CST);
-						auto n = solver_state.solns.size();
+			// the numbering might have changed, so carry the assignments over by name.
+			auto old_names = std::move(foundVariables);
 
-						lg::log("solver", "done: {} solution(s)", solver_state.solns.size());
-						if(solver_state.solns.size() > 0)
-							ui::logMessage(zpr::sprint("{} solution{} found", n, n == 1 ? "" : "s"), 5);
+			foundVariables = std::vector<std::string>(vars.begin(), vars.end());
+			variableIndices.clear();
+			for(size_t i = 0; i < foundVariables.size(); i++)
+				variableIndices[foundVariables[i]] = i;
 
-						else
-							ui::logMessage("unsatisfiable", 5);
-					}, get_cached_expr(graph));
+			find_variable_items(graph);
 
-					t.detach();
-				}
-			}
+			evaluator = solver::Evaluator(expr, foundVariables);
+			evaluator_stale = true;
 
-			if(!done && solver_state.did_solve)
+			varAssigns = solver::PartialAssignment(foundVariables.size());
+			for(size_t i = 0; i < old_assigns.size(); i++)
 			{
-				auto [ c, t ] = solver_progress;
-				double prog = (double) c / (double) t;
-				imgui::ProgressBar(prog, lx::vec2(0, 0), zpr::sprint("{.1f}%", 100 * prog).c_str());
+				if(auto it = variableIndices.find(old_names[i]); old_assigns.isAssigned(i) && it != variableIndices.end())
+					varAssigns.set(it->second, old_assigns.get(i));
 			}
-			else if(done && solver_state.did_solve)
-			{
-				if(solver_state.solns.empty())
-				{
-					auto s = Styler();
-					s.push(ImGuiCol_Text, theme.boxSelection);
 
-					imgui::NewLine();
-					imgui::SameLine(0, 4);
-					imgui::Text("unsatisfiable");
-				}
-				else
-				{
-					{
-						auto s = Styler();
-						s.push(ImGuiCol_Text, theme.boxDropTarget);
-
-						auto n = solver_state.solns.size();
-						imgui::NewLine();
-						imgui::SameLine(0, 4);
-						imgui::TextUnformatted(zpr::sprint("{} solution{}",
-							n, n == 1 ? "" : "s").c_str());
-					}
-
-					bool changed = false;
-
-					if(solver_state.waiting)
-					{
-						// on the first go-around, assign the first solution.
-						changed = true;
-						solver_state.index = 0;
-						solver_state.waiting = false;
-					}
-
-					{
-						auto s = disabled_style(solver_state.index == 0);
-						auto ss = flash_style(SB_BUTTON_V_PREV_SOLN);
-						if(imgui::Button("\uf177 prev "))
-							changed = true, solver_state.index -= 1;
-					}
-
-					imgui::SameLine();
-
-					{
-						auto s = disabled_style(solver_state.index + 1 >= solver_state.solns.size());
-						auto ss = flash_style(SB_BUTTON_V_NEXT_SOLN);
-						if(imgui::Button(" next \uf178"))
-							changed = true, solver_state.index += 1;
-					}
-
-					if(changed)
-					{
-						varAssigns = solver_state.solns[solver_state.index];
-						set_flags(graph, varAssigns);
-					}
-				}
-			}
+			restore_soln(graph, varAssigns);
 		}
-
-		imgui::Unindent();
-		imgui::PopID();
 	}
 
-	// used by interact.cpp
-	void prev_solution(Graph* graph)
-	{
-		if(!solver_state.did_solve)
-			return;
-
-		if(solver_state.index > 0)
-			solver_state.index -= 1;
-
-		varAssigns = solver_state.solns[solver_state.index];
-		set_flags(graph, varAssigns);
-	}
-
-	void next_solution(Graph* graph)
+	void eval_tools(Graph* graph)
 	{
-		if(!solver_state.did_solve)
-			return;
+		imgui::PushID("__scope_eval");
 
-		if(solver_state.index + 1 < solver_state.solns.size())
-			solver_state.index += 1;
+		solver_tool(graph);
+		imgui::NewLine();
 
-		varAssigns = solver_state.solns[solver_state.index];
-		set_flags(graph, varAssigns);
-	}
+		variable_assign_tool(graph);
 
-	void solve_expression()
-	{
-		solve_requested = true;
+		imgui::PopID();
 	}
 
 
-
 	static void variable_assign_tool(Graph* graph)
 	{
 		auto& theme = ui::theme();
@@ -249,6 +183,7 @@ namespace ui
 
 		imgui::PushID("__scope_assign");
 		auto copy = varAssigns;
+		bool projection_changed = false;
 
 		{
 			lx::vec2 cursor = imgui::GetCursorPos();
@@ -262,19 +197,19 @@ namespace ui
 			// fa-undo-alt
 			imgui::SetCursorPos(cursor + lx::vec2(174, -4));
 			if(imgui::Button("\uf2ea"))
-				copy.clear();
+				copy = solver::PartialAssignment(foundVariables.size());
 		}
 
 		auto ypos = imgui::GetCursorPos().y;
 		imgui::BeginChild("__variables", lx::vec2(0, geom.sidebar.size.y - 45 - ypos));
 		imgui::Indent();
 
-		auto button_style = [&copy, &theme](const std::string& name) -> Styler {
-			if(auto it = copy.find(name); it != copy.end())
+		auto button_style = [&copy, &theme](size_t idx) -> Styler {
+			if(copy.isAssigned(idx))
 			{
-				if(it->second)
+				if(copy.get(idx))
 				{
-					return toggle_enabled_style(it->second);
+					return toggle_enabled_style(true);
 				}
 				else
 				{
@@ -291,48 +226,75 @@ namespace ui
 			}
 		};
 
-		// this will be sorted since we're using an ordered set,
+		// this will be sorted since we sort the variables when we find them,
 		// which is nice.
-		int n = 0;
-		for(const auto& var : foundVariables)
+		for(size_t n = 0; n < foundVariables.size(); n++)
 		{
 			// 0 = none, 1 = true, 2 = false
-			int state = 0;
-			if(auto it = copy.find(var); it != copy.end())
-			{
-				if(it->second)  state = 1;
-				else            state = 2;
-			}
+			int state = get_var_state(copy, n);
 
 			// question-circle: f059, dot-circle: f192, circle: f111
 			auto shortcut = (n > 9 ? " " : std::to_string((1 + n) % 10));
 
 			auto text = zpr::sprint("{} {} {} ", shortcut,
-				state == 0 ? "\uf059" : state == 1 ? "\uf192" : "\uf111", var);
+				state == 0 ? "\uf059" : state == 1 ? "\uf192" : "\uf111", foundVariables[n]);
 
-			auto s = button_style(var);
-			if(imgui::Button(text.c_str()))
 			{
-				state = (state + 1) % 3;
-				if(state == 0) copy.erase(var);
-				if(state == 1) copy[var] = true;
-				if(state == 2) copy[var] = false;
+				auto s = button_style(n);
+				if(imgui::Button(text.c_str()))
+				{
+					state = (state + 1) % 3;
+					if(state == 0) copy.unset(n);
+					if(state == 1) copy.set(n, true);
+					if(state == 2) copy.set(n, false);
+				}
 			}
 
-			n += 1;
+			// the weight, for optimising.
+			{
+				auto s = Styler();
+				s.push(ImGuiCol_FrameBg, theme.textFieldBg);
+
+				imgui::SameLine(150);
+				imgui::SetNextItemWidth(40);
+				imgui::PushID((int) n);
+
+				auto weight = weight_of(foundVariables[n]);
+				if(imgui::InputScalar("##weight", ImGuiDataType_S64, &weight))
+				{
+					variableWeights[foundVariables[n]] = weight;
+					forget_optimum();
+				}
+
+				// eye: f06e, eye-slash: f070
+				imgui::SameLine();
+				bool hidden = hiddenVariables.count(foundVariables[n]) > 0;
+				if(imgui::Button(hidden ? "\uf070" : "\uf06e"))
+				{
+					if(hidden) hiddenVariables.erase(foundVariables[n]);
+					else       hiddenVariables.insert(foundVariables[n]);
+
+					projection_changed = true;
+				}
+
+				imgui::PopID();
+			}
 		}
 
 		imgui::Unindent();
 		imgui::EndChild();
 
-		if(vars_updated || varAssigns != copy || !ui::showingEvalExpr())
+		if(vars_updated || projection_changed || varAssigns != copy || !ui::showingEvalExpr())
 		{
+			// if nothing actually changed (eg. we just came back to evaluate mode), then
+			// whatever was showing before can come right back.
+			auto pins = (varAssigns == copy) ? user_pins() : copy;
 			varAssigns = copy;
-			auto result = get_cached_expr(graph)->evaluate(varAssigns);
 
 			reset_soln();
-			ui::showEvalExpr(zpr::sprint("result: {}", expr_to_string(result)));
-			set_flags(graph, varAssigns);
+			restore_soln(graph, pins);
+			look_for_saved_search(graph, pins);
+			refresh_assignments(graph, /* everything: */ evaluator_stale || !ui::showingEvalExpr());
 		}
 
 		vars_updated = false;
@@ -368,69 +330,100 @@ namespace ui
 		}
 	}
 
-	void set_flags(Graph* graph, const std::unordered_map<std::string, bool>& soln)
+	static void set_var_flags(Item* item, const solver::PartialAssignment& soln, size_t var)
+	{
+		item->flags &= ~(FLAG_VAR_ASSIGN_TRUE | FLAG_VAR_ASSIGN_FALSE);
+		if(var < soln.size() && soln.isAssigned(var))
+		{
+			if(soln.get(var))   item->flags |= FLAG_VAR_ASSIGN_TRUE;
+			else                item->flags |= FLAG_VAR_ASSIGN_FALSE;
+		}
+	}
+
+	void set_flags(Graph* graph, const solver::PartialAssignment& soln)
 	{
 		for_each_var(&graph->box, [&soln](auto item) {
-			item->flags &= ~(FLAG_VAR_ASSIGN_TRUE | FLAG_VAR_ASSIGN_FALSE);
-			if(auto it = soln.find(item->name); it != soln.end())
-			{
-				if(it->second)  item->flags |= FLAG_VAR_ASSIGN_TRUE;
-				else            item->flags |= FLAG_VAR_ASSIGN_FALSE;
-			}
+			if(auto it = variableIndices.find(item->name); it != variableIndices.end())
+				set_var_flags(item, soln, it->second);
+			else
+				item->flags &= ~(FLAG_VAR_ASSIGN_TRUE | FLAG_VAR_ASSIGN_FALSE);
 		});
 	}
 
-	void toggleVariableState(int num)
+	static void find_variable_items(Graph* graph)
 	{
-		int x = 0;
-		auto it = foundVariables.begin();
-		while(x < num)
-		{
-			if(it == foundVariables.end())
-				return;
+		variableItems.clear();
+		variableItems.resize(foundVariables.size());
+
+		for_each_var(&graph->box, [](auto item) {
+			if(auto it = variableIndices.find(item->name); it != variableIndices.end())
+				variableItems[it->second].push_back(item);
+		});
+	}
+
+	// only re-evaluates (and redraws) what the changed variables affect, unless `everything`.
+	void refresh_assignments(Graph* graph, bool everything)
+	{
+		static std::vector<uint32_t> changed;
+		evaluator.update(varAssigns, changed);
 
-			++it;
-			++x;
+		if(everything)
+		{
+			set_flags(graph, varAssigns);
+		}
+		else
+		{
+			for(auto var : changed)
+			{
+				for(auto item : variableItems[var])
+					set_var_flags(item, varAssigns, var);
+			}
 		}
 
-		auto name = *it;
-		int state = get_var_state(varAssigns, name);
+		evaluator_stale = false;
+		ui::showEvalExpr(zpr::sprint("result: {}", result_string(get_cached_expr(graph))));
+	}
+
+	void toggleVariableState(int num)
+	{
+		if(num < 0 || (size_t) num >= foundVariables.size())
+			return;
+
+		int state = get_var_state(varAssigns, num);
 		state = (state + 1) % 3;
 
-		if(state == 0) varAssigns.erase(name);
-		if(state == 1) varAssigns[name] = true;
-		if(state == 2) varAssigns[name] = false;
+		if(state == 0) varAssigns.unset(num);
+		if(state == 1) varAssigns.set(num, true);
+		if(state == 2) varAssigns.set(num, false);
 
 		vars_updated = true;
 		reset_soln();
 	}
 
-
-
-	static void find_variables(ast::Expr* expr)
+	void find_variables(ast::Expr* expr, std::set<std::string>& vars)
 	{
 		if(auto l = dynamic_cast<ast::Lit*>(expr); l != nullptr)
 			;
 
 		else if(auto v = dynamic_cast<ast::Var*>(expr); v != nullptr)
-			foundVariables.insert(v->name);
+			vars.insert(v->name);
 
 		else if(auto n = dynamic_cast<ast::Not*>(expr); n != nullptr)
-			find_variables(n->e);
+			find_variables(n->e, vars);
 
 		else if(auto a = dynamic_cast<ast::And*>(expr); a != nullptr)
-			find_variables(a->left), find_variables(a->right);
+			find_variables(a->left, vars), find_variables(a->right, vars);
 
 		else
 			abort();
 	}
 
-	static int get_var_state(const std::unordered_map<std::string, bool>& vars, const std::string& name)
+	static int get_var_state(const solver::PartialAssignment& vars, size_t idx)
 	{
-		if(auto it = vars.find(name); it != vars.end())
+		if(vars.isAssigned(idx))
 		{
-			if(it->second)  return 1;
-			else            return 2;
+			if(vars.get(idx))   return 1;
+			else                return 2;
 		}
 		else
 		{
@@ -5,6 +5,7 @@
 #include "ui.h"
 #include "ast.h"
 #include "alpha.h"
+#include "solver.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
 
@@ -44,7 +45,7 @@ namespace ui
 	// sidebar/evaluate.cpp
 	void eval_tools(Graph* graph);
 	void rescan_variables(Graph* graph);
-	void set_flags(Graph* graph, const std::unordered_map<std::string, bool>& soln);
+	void set_flags(Graph* graph, const solver::PartialAssignment& soln);
 
 	void draw_sidebar(Graph* graph)
 	{
@@ -0,0 +1,1513 @@
+// solve.cpp
+// Copyright (c) 2021, zhiayang
+// Licensed under the Apache License Version 2.0.
+
+#include <cstdio>
+#include <filesystem>
+
+#include "ui.h"
+#include "ast.h"
+#include "alpha.h"
+#include "solver.h"
+#include "imgui/imgui.h"
+
+namespace imgui = ImGui;
+using namespace alpha;
+
+namespace alpha
+{
+	// util/solver.cpp
+	solver::Cursor* make_brute_force_solver(ast::Expr* expr, const std::vector<std::string>& vars, bool parallel,
+		const solver::PartialAssignment& pins);
+
+	solver::Cursor* make_gray_code_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins);
+
+	solver::Cursor* make_process_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, std::shared_ptr<solver::WorkerPool> pool);
+
+	solver::Cursor* make_sat_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins);
+
+	solver::Cursor* make_projected_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, const std::vector<bool>& shown);
+
+	solver::Cursor* make_sampler(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, size_t limit, solver::Job& job);
+
+	solver::Cursor* make_bdd_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, solver::Job& job);
+
+	int step_solver(solver::Cursor* cursor, bool forward, solver::Job& job);
+
+	bool count_models(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::BigNum* out, solver::Job& job);
+
+	int find_counterexample(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::PartialAssignment* out, solver::Job& job);
+
+	int check_equivalent(ast::Expr* a, ast::Expr* b, const std::vector<std::string>& vars,
+		solver::PartialAssignment* out, solver::Job& job);
+
+	bool find_cover(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		std::vector<solver::PartialAssignment>* out, bool* complete, solver::Job& job);
+
+	bool approx_count(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		double epsilon, double delta, solver::BigNum* out, bool* exact, solver::Job& job);
+
+	int optimise(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		const std::vector<int64_t>& weights, bool maximise, solver::PartialAssignment* out, int64_t* cost,
+		solver::Job& job);
+
+	int find_backbone(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::PartialAssignment* out, solver::Job& job);
+
+	bool count_marginals(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		std::vector<solver::BigNum>* out, solver::BigNum* total, solver::Job& job);
+}
+
+namespace ui
+{
+	// defined in exprbar.cpp
+	std::string expr_to_string(ast::Expr* expr);
+
+	Styler flash_style(int button);
+	Styler disabled_style(bool disabled);
+
+	// sidebar/evaluate.cpp
+	const std::vector<std::string>& found_variables();
+	solver::PartialAssignment& var_assigns();
+	std::vector<bool> current_projection();
+	int64_t weight_of(const std::string& var);
+	void refresh_assignments(Graph* graph, bool everything);
+	void set_flags(Graph* graph, const solver::PartialAssignment& soln);
+	void find_variables(ast::Expr* expr, std::set<std::string>& vars);
+
+	static bool maximise_weight = false;
+
+	static constexpr int ENGINE_SERIAL      = 0;
+	static constexpr int ENGINE_PARALLEL    = 1;
+	static constexpr int ENGINE_SAT         = 2;
+	static constexpr int ENGINE_BDD         = 3;
+	static constexpr int ENGINE_GRAY_CODE   = 4;
+	static constexpr int ENGINE_SAMPLE      = 5;
+	static constexpr int ENGINE_PROCESSES   = 6;
+
+	static int solver_engine = ENGINE_SERIAL;
+
+	// the processes engine runs copies of this program (see solver::WorkerPool); they're only
+	// started when they're first needed, and stay around for the next solve.
+	static std::string worker_program;
+	static std::shared_ptr<solver::WorkerPool> worker_pool;
+
+	// how many random solutions the sample engine draws.
+	static constexpr int MAX_SAMPLES = 100000;
+	static int sample_count = 100;
+	static bool solve_requested = false;
+
+	// results only get handed over in jobs.poll(), on the ui thread, so solver_state doesn't need a lock.
+	static solver::JobRunner jobs;
+	static struct {
+		bool waiting = false;
+		bool did_solve = false;
+
+		// solutions are only found when they're asked for, so there's only ever one of them around.
+		solver::Cursor* cursor = nullptr;
+
+		// the variables that were pinned when the solve started; once a solution is showing,
+		// varAssigns holds that instead, so solving again needs to remember these.
+		solver::PartialAssignment pins;
+		int engine = ENGINE_SERIAL;
+
+		// which variables the solutions are over, if not all of them; see hiddenVariables.
+		std::vector<bool> projection;
+
+		bool counted = false;
+		solver::BigNum count;
+
+		// for when there are too many variables to count exactly; see APPROX_EPSILON.
+		bool estimated = false;
+		bool estimateExact = false;
+		solver::BigNum estimate;
+
+		// whether the expression is true for every assignment (that agrees with the pins); if
+		// not, this is one that makes it false.
+		bool checked = false;
+		bool valid = false;
+		solver::PartialAssignment counterexample;
+
+		// an answer (eg. the counterexample) that's showing in varAssigns; like pins, for solving,
+		// this remembers what the user had pinned. see show_assignment().
+		bool showing = false;
+		solver::PartialAssignment shownPins;
+
+		// whether the expression is the same as the one in compare_buffer; if not, this is where they
+		// differ. the other one might have variables that we don't, so those go after ours.
+		bool compared = false;
+		bool equivalent = false;
+		solver::PartialAssignment difference;
+		std::vector<std::string> compareVars;
+
+		// the solutions, summed up as cubes (with don't-cares); picking one shows it in varAssigns,
+		// so (like pins, for solving) this remembers what the user had pinned.
+		bool covered = false;
+		bool coverComplete = false;
+		std::vector<solver::PartialAssignment> cubes;
+		solver::PartialAssignment coverPins;
+		int selectedCube = -1;
+
+		// how often each variable is true, over all the solutions, and which ones are always the
+		// same (the backbone). the backbone comes first, so it's there even if counting fails.
+		bool analysed = false;
+		bool satisfiable = false;
+		solver::PartialAssignment backbone;
+		bool marginalsCounted = false;
+		std::vector<solver::BigNum> trueCounts;
+		solver::BigNum totalCount;
+
+		// the solution with the smallest (or largest) total weight; see variableWeights.
+		bool optimised = false;
+		bool optimumFound = false;
+		solver::PartialAssignment optimum;
+		int64_t optimumWeight = 0;
+
+		// which graph (and pins) the results are for; see results_key().
+		std::string key;
+
+		// finding (or stepping to) a solution, counting, and checking; these can all run at the same
+		// time. the cursor belongs to the solve job while it runs, so nothing else should touch it.
+		std::shared_ptr<solver::Job> solveJob;
+		std::shared_ptr<solver::Job> countJob;
+		std::shared_ptr<solver::Job> estimateJob;
+		std::shared_ptr<solver::Job> checkJob;
+		std::shared_ptr<solver::Job> compareJob;
+		std::shared_ptr<solver::Job> coverJob;
+		std::shared_ptr<solver::Job> statsJob;
+		std::shared_ptr<solver::Job> optimiseJob;
+	} solver_state;
+
+	// the estimate is within a factor of (1 + epsilon) of the real count, with probability (1 - delta).
+	static constexpr double APPROX_EPSILON  = 0.8;
+	static constexpr double APPROX_DELTA    = 0.2;
+
+	// long brute-force searches get saved every so often (and when interrupted), so they can be resumed after a restart.
+	static constexpr double SAVE_SEARCH_INTERVAL = 10;
+	static std::filesystem::path save_search_dir;
+
+	// a saved search for what's showing now, if there is one; see look_for_saved_search().
+	static bool have_saved_search = false;
+	static solver::SavedSearch saved_search;
+
+	static constexpr size_t COMPARE_BUFFER_SIZE = 1024;
+	static char compare_buffer[COMPARE_BUFFER_SIZE + 1];
+
+	// old results are kept around, in case the graph goes back to how it was (eg. with undo).
+	static constexpr size_t DEFAULT_CACHE_LIMIT = 256 * 1024 * 1024;
+	static solver::ResultCache result_cache(DEFAULT_CACHE_LIMIT);
+
+	static void stash_results(const std::string& key, solver::Cursor* cursor, bool counted, const solver::BigNum& count)
+	{
+		// a cursor that was stopped before it found anything doesn't know anything, and samples
+		// would get restored for the next solve (with any engine) as if they were the solutions.
+		if(cursor != nullptr && ((!cursor->valid() && cursor->hasNext()) || cursor->isSample()))
+		{
+			delete cursor;
+			cursor = nullptr;
+		}
+
+		if(cursor != nullptr || counted)
+			result_cache.put(key, { cursor, counted, count });
+	}
+
+	// `keep_jobs` leaves the count and the checks alone, for when the graph and the pins haven't changed.
+	void reset_soln(bool keep_jobs = false)
+	{
+		// a job that's still running keeps whatever it was working on; when it finishes and sees
+		// that it was replaced, it puts that away itself.
+		if(solver_state.solveJob != nullptr)
+		{
+			solver_state.solveJob->cancel();
+			solver_state.solveJob = nullptr;
+		}
+		else
+		{
+			// anything that finished goes into the cache instead of getting thrown away.
+			stash_results(solver_state.key, solver_state.cursor, solver_state.counted, solver_state.count);
+		}
+
+		solver_state.cursor = nullptr;
+		solver_state.did_solve = false;
+		solver_state.waiting = false;
+		solver_state.counted = false;
+		solver_state.showing = false;
+
+		if(keep_jobs)
+			return;
+
+		for(auto job : { &solver_state.countJob, &solver_state.estimateJob, &solver_state.checkJob, &solver_state.compareJob,
+			&solver_state.coverJob, &solver_state.statsJob, &solver_state.optimiseJob })
+		{
+			if(*job != nullptr)
+				(*job)->cancel();
+
+			*job = nullptr;
+		}
+
+		solver_state.estimated = false;
+		solver_state.checked = false;
+		solver_state.compared = false;
+		solver_state.covered = false;
+		solver_state.cubes.clear();
+		solver_state.selectedCube = -1;
+		solver_state.analysed = false;
+		solver_state.optimised = false;
+	}
+
+	// everything the results depend on (the graph, and each variable's pin and whether it's hidden), spelled
+	// out in full so that two different graphs can't get each other's results.
+	static std::string results_key(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		auto key = alpha::canonicalGraph(&graph->box);
+		auto projection = current_projection();
+
+		for(size_t i = 0; i < found_variables().size(); i++)
+		{
+			auto& name = found_variables()[i];
+			auto pin = (i < pins.size() && pins.isAssigned(i)) ? (pins.get(i) ? '1' : '0') : '-';
+			auto hidden = (i < projection.size() && !projection[i]) ? "~" : "";
+
+			key += zpr::sprint("|{}:{}{}{}", name.size(), name, pin, hidden);
+		}
+
+		return key;
+	}
+
+	// brings back the results for this graph and these pins, if we have them.
+	bool restore_soln(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		if(solver_state.solveJob != nullptr)
+			return false;
+
+		auto key = results_key(graph, pins);
+		auto entry = solver::ResultCache::Entry();
+		if(!result_cache.take(key, &entry))
+			return false;
+
+		solver_state.key = key;
+		solver_state.pins = pins;
+		solver_state.projection = current_projection();
+		solver_state.cursor = entry.cursor;
+
+		// a count that's still running will say the same thing soon enough.
+		if(solver_state.countJob == nullptr)
+		{
+			solver_state.counted = entry.counted;
+			solver_state.count = entry.count;
+		}
+
+		// the next frame will show the solution that the cursor was on.
+		solver_state.did_solve = (entry.cursor != nullptr);
+		solver_state.waiting = solver_state.did_solve;
+
+		return true;
+	}
+
+	void setSolverCacheLimit(size_t bytes)
+	{
+		result_cache.setLimit(bytes);
+	}
+
+	void setSavedSearchDir(const std::string& path)
+	{
+		save_search_dir = path;
+	}
+
+	void setSolverWorkerProgram(const std::string& path)
+	{
+		worker_program = path;
+	}
+
+	// what the user pinned, as opposed to whatever is showing (a solution, or a cube).
+	const solver::PartialAssignment& user_pins()
+	{
+		if(solver_state.showing)
+			return solver_state.shownPins;
+
+		if(solver_state.did_solve)
+			return solver_state.pins;
+
+		if(solver_state.selectedCube >= 0)
+			return solver_state.coverPins;
+
+		return var_assigns();
+	}
+
+	// puts an answer in varAssigns, so it gets evaluated (and drawn) like anything the user pinned.
+	static void show_assignment(Graph* graph, const solver::PartialAssignment& soln)
+	{
+		if(!solver_state.showing)
+			solver_state.shownPins = user_pins();
+
+		solver_state.showing = true;
+
+		// anything past our variables (eg. from the other side of a comparison) can't be shown.
+		var_assigns() = solver::PartialAssignment(found_variables().size());
+		for(size_t i = 0; i < found_variables().size() && i < soln.size(); i++)
+		{
+			if(soln.isAssigned(i))
+				var_assigns().set(i, soln.get(i));
+		}
+
+		refresh_assignments(graph, /* everything: */ true);
+	}
+
+	static bool have_solution()
+	{
+		return solver_state.cursor != nullptr && solver_state.cursor->valid();
+	}
+
+	static solver::PartialAssignment get_solution()
+	{
+		return solver::PartialAssignment(solver_state.cursor->values());
+	}
+
+	static std::string solution_count_string()
+	{
+		if(solver_state.cursor->isSample())
+			return "random solutions";
+
+		auto kind = solver_state.projection.empty() ? "" : "projected ";
+
+		auto count = solver::BigNum();
+		if(!solver_state.cursor->count(&count))
+			return zpr::sprint("{}+ {}solutions", solver_state.cursor->index() + 1, kind);
+
+		return zpr::sprint("{} {}solution{}", count.str(), kind, count == solver::BigNum(1) ? "" : "s");
+	}
+
+	static size_t num_pinned(const solver::PartialAssignment& pins)
+	{
+		size_t ret = 0;
+		for(auto w : pins.assigned.words)
+			ret += __builtin_popcountll(w);
+
+		return ret;
+	}
+
+	// how many variables the solutions are different combinations of.
+	static size_t num_enumerated(const solver::PartialAssignment& pins, const std::vector<bool>& projection)
+	{
+		size_t ret = 0;
+		for(size_t k = 0; k < found_variables().size(); k++)
+		{
+			if(!pins.isAssigned(k) && (projection.empty() || projection[k]))
+				ret++;
+		}
+
+		return ret;
+	}
+
+	static bool is_brute_force(int engine)
+	{
+		return engine == ENGINE_SERIAL || engine == ENGINE_PARALLEL || engine == ENGINE_GRAY_CODE
+			|| engine == ENGINE_PROCESSES;
+	}
+
+	// the cursor is back in our hands; returns false if nobody wants it anymore.
+	static bool finish_solve(const solver::Job& job, solver::Cursor* cursor, const std::string& key)
+	{
+		// the graph (or the pins) changed while we were busy, so this is for something else now.
+		if(solver_state.solveJob.get() != &job)
+		{
+			stash_results(key, cursor, false, solver::BigNum());
+			return false;
+		}
+
+		solver_state.solveJob = nullptr;
+		solver_state.cursor = cursor;
+		return true;
+	}
+
+	// where to save a search, or empty if it can't be picked up again anyway.
+	static std::string saved_search_path(const std::string& key, int engine, const std::vector<bool>& projection)
+	{
+		if(!is_brute_force(engine) || !projection.empty())
+			return "";
+
+		auto ec = std::error_code();
+		if(save_search_dir.empty())
+		{
+			save_search_dir = std::filesystem::temp_directory_path(ec) / "peirce-alpha";
+			if(ec)
+				return "";
+		}
+
+		std::filesystem::create_directories(save_search_dir, ec);
+		if(ec)
+			return "";
+
+		return (save_search_dir / zpr::sprint("{016x}.search", (uint64_t) std::hash<std::string>()(key))).string();
+	}
+
+	// called from the job that's stepping the cursor, so it can only look at what it was given.
+	static void save_search(solver::Cursor* cursor, const std::string& path, solver::SavedSearch search)
+	{
+		if(path.empty() || !cursor->save(&search.cursor))
+			return;
+
+		if(!solver::writeSavedSearch(path, search))
+			lg::warn("solver", "could not save search to '{}'", path);
+	}
+
+	static void watch_search(solver::Cursor* cursor, const std::string& path, const solver::SavedSearch& search)
+	{
+		if(path.empty())
+			return;
+
+		cursor->onFrontier = [cursor, path, search, last = std::chrono::steady_clock::now()]() mutable {
+			auto now = std::chrono::steady_clock::now();
+			if(std::chrono::duration<double>(now - last).count() < SAVE_SEARCH_INTERVAL)
+				return;
+
+			last = now;
+			save_search(cursor, path, search);
+		};
+	}
+
+	// once a step is done, there's either somewhere new to carry on from, or nothing left to find.
+	static void end_search(const solver::Job& job, solver::Cursor* cursor, int result, bool forward,
+		const std::string& path, const solver::SavedSearch& search)
+	{
+		if(path.empty())
+			return;
+
+		if(result == solver::Cursor::STEP_END && forward)
+			std::remove(path.c_str());
+
+		else if(result != solver::Cursor::STEP_END && job.elapsed() >= SAVE_SEARCH_INTERVAL)
+			save_search(cursor, path, search);
+	}
+
+	void look_for_saved_search(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		have_saved_search = false;
+
+		auto key = results_key(graph, pins);
+		auto path = saved_search_path(key, ENGINE_SERIAL, current_projection());
+		if(path.empty() || !std::filesystem::exists(path))
+			return;
+
+		// the file is only named after a hash of the key, so make sure that it's really for this.
+		auto search = solver::SavedSearch();
+		if(!solver::readSavedSearch(path, &search) || search.key != key || search.pins != pins
+			|| !is_brute_force((int) search.engine))
+		{
+			lg::warn("solver", "ignoring saved search '{}'", path);
+			return;
+		}
+
+		have_saved_search = true;
+		saved_search = std::move(search);
+	}
+
+	// moves the cursor on a separate thread, since the next solution might be a long way off.
+	static void start_step(bool forward)
+	{
+		auto search = solver::SavedSearch();
+		search.key = solver_state.key;
+		search.engine = (uint32_t) solver_state.engine;
+		search.pins = solver_state.pins;
+
+		solver_state.waiting = true;
+		solver_state.solveJob = jobs.start([cursor = solver_state.cursor, key = solver_state.key, forward, search,
+			path = saved_search_path(solver_state.key, solver_state.engine, solver_state.projection)]
+			(solver::Job& job) -> std::function<void ()> {
+
+			auto result = alpha::step_solver(cursor, forward, job);
+			end_search(job, cursor, result, forward, path, search);
+
+			return [&job, cursor, key]() {
+				finish_solve(job, cursor, key);
+			};
+		});
+	}
+
+	// `resume` picks up a saved search (with the engine it was using) instead of starting over.
+	static void start_solve(Graph* graph, const solver::PartialAssignment& pins, size_t num_free, bool brute_force,
+		const solver::SavedSearch* resume = nullptr)
+	{
+		if(num_free >= 16 && brute_force)
+			ui::logMessage(zpr::sprint("solving {} variables; this might take some time...", num_free), 3);
+
+		auto engine = resume ? (int) resume->engine : solver_engine;
+
+		solver_state.waiting = true;
+		solver_state.did_solve = true;
+		solver_state.pins = pins;
+		solver_state.engine = engine;
+		solver_state.key = results_key(graph, pins);
+
+		// samples are always of whole solutions.
+		solver_state.projection = (engine == ENGINE_SAMPLE) ? std::vector<bool>() : current_projection();
+
+		auto search = solver::SavedSearch();
+		search.key = solver_state.key;
+		search.engine = (uint32_t) engine;
+		search.pins = pins;
+
+		if(resume != nullptr)
+			search.cursor = resume->cursor;
+
+		if(engine == ENGINE_PROCESSES && worker_pool == nullptr)
+			worker_pool = std::make_shared<solver::WorkerPool>(worker_program, solver::numHardwareThreads());
+
+		// the job gets its own copy of the expression and the variables, since the graph can be
+		// edited (and rescanned) while we're solving.
+		solver_state.solveJob = jobs.start([expr = graph->expr(), engine, vars = found_variables(),
+			pins, key = solver_state.key, limit = sample_count, shown = solver_state.projection,
+			search, resuming = (resume != nullptr), pool = worker_pool,
+			path = saved_search_path(solver_state.key, engine, solver_state.projection)]
+			(solver::Job& job) -> std::function<void ()> {
+
+			solver::Cursor* cursor = nullptr;
+
+			// the other engines would find every hidden combination of each one, so this overrides them.
+			if(!shown.empty())
+				cursor = alpha::make_projected_solver(expr, vars, pins, shown);
+
+			else if(engine == ENGINE_SAT)
+				cursor = alpha::make_sat_solver(expr, vars, pins);
+
+			else if(engine == ENGINE_BDD)
+				cursor = alpha::make_bdd_solver(expr, vars, pins, job);
+
+			else if(engine == ENGINE_GRAY_CODE)
+				cursor = alpha::make_gray_code_solver(expr, vars, pins);
+
+			else if(engine == ENGINE_SAMPLE)
+				cursor = alpha::make_sampler(expr, vars, pins, (size_t) limit, job);
+
+			else if(engine == ENGINE_PROCESSES)
+				cursor = alpha::make_process_solver(expr, vars, pins, pool);
+
+			else
+				cursor = alpha::make_brute_force_solver(expr, vars, /* parallel: */ engine == ENGINE_PARALLEL, pins);
+
+			delete expr;
+
+			if(cursor != nullptr)
+				watch_search(cursor, path, search);
+
+			// a search that was on a solution (and hadn't started looking for the next one) can
+			// show that one again; otherwise it carries on from wherever it got to.
+			bool resumed = resuming && cursor != nullptr && cursor->resume(search.cursor);
+			if(resuming && cursor != nullptr && !resumed)
+				lg::warn("solver", "could not resume the saved search; starting over");
+
+			auto result = solver::Cursor::STEP_ABORTED;
+			if(resumed && search.cursor.hasCurrent && search.cursor.scanned == 0)
+				result = solver::Cursor::STEP_FOUND;
+
+			// find the first solution straight away; the rest can wait until they're asked for.
+			else if(cursor != nullptr)
+				result = alpha::step_solver(cursor, /* forward: */ true, job);
+
+			if(cursor != nullptr)
+				end_search(job, cursor, result, /* forward: */ true, path, search);
+
+			return [&job, cursor, key, result, engine]() {
+				if(!finish_solve(job, cursor, key))
+					return;
+
+				if(cursor == nullptr)
+				{
+					solver_state.did_solve = false;
+					if(!job.isCancelled() && engine == ENGINE_BDD)
+						ui::logMessage("bdd too large; try the sat engine", 5);
+					else if(!job.isCancelled() && is_brute_force(engine))
+						ui::logMessage("too many variables to brute-force; try the sat engine", 5);
+				}
+				else if(result == solver::Cursor::STEP_FOUND)
+				{
+					lg::log("solver", "done: {}", solution_count_string());
+					ui::logMessage(zpr::sprint("{} found", solution_count_string()), 5);
+				}
+				else if(result == solver::Cursor::STEP_END)
+				{
+					ui::logMessage("unsatisfiable", 5);
+				}
+			};
+		});
+	}
+
+	// counting doesn't need an engine, and works for far more variables than enumerating.
+	static void start_count(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		solver_state.counted = false;
+		solver_state.key = results_key(graph, pins);
+
+		solver_state.countJob = jobs.start([expr = graph->expr(), vars = found_variables(),
+			pins](solver::Job& job) -> std::function<void ()> {
+
+			auto count = solver::BigNum();
+			bool ok = alpha::count_models(expr, vars, pins, &count, job);
+
+			delete expr;
+			return [&job, ok, count]() {
+				if(solver_state.countJob.get() != &job)
+					return;
+
+				solver_state.countJob = nullptr;
+				solver_state.counted = ok;
+				solver_state.count = count;
+
+				if(ok)
+				{
+					lg::log("solver", "counted: {}", count.str());
+					ui::logMessage(zpr::sprint("{} model{}", count.str(), count == solver::BigNum(1) ? "" : "s"), 5);
+				}
+			};
+		});
+	}
+
+	static void start_estimate(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		solver_state.estimated = false;
+		solver_state.estimateJob = jobs.start([expr = graph->expr(), vars = found_variables(),
+			pins](solver::Job& job) -> std::function<void ()> {
+
+			auto estimate = solver::BigNum();
+			bool exact = false;
+			bool ok = alpha::approx_count(expr, vars, pins, APPROX_EPSILON, APPROX_DELTA, &estimate, &exact, job);
+
+			delete expr;
+			return [&job, ok, exact, estimate]() {
+				if(solver_state.estimateJob.get() != &job)
+					return;
+
+				solver_state.estimateJob = nullptr;
+				solver_state.estimated = ok;
+				solver_state.estimateExact = exact;
+				solver_state.estimate = estimate;
+
+				if(ok)
+					lg::log("solver", "estimated: {}{}", exact ? "" : "~", estimate.str());
+			};
+		});
+	}
+
+	// the weights (or the goal) changed, so whatever we found (or are finding) is for something else.
+	void forget_optimum()
+	{
+		if(solver_state.optimiseJob != nullptr)
+			solver_state.optimiseJob->cancel();
+
+		solver_state.optimiseJob = nullptr;
+		solver_state.optimised = false;
+	}
+
+	static void start_optimise(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		auto weights = std::vector<int64_t>();
+		for(auto& v : found_variables())
+			weights.push_back(weight_of(v));
+
+		solver_state.optimised = false;
+		solver_state.optimiseJob = jobs.start([expr = graph->expr(), vars = found_variables(), pins,
+			weights = std::move(weights), maximise = maximise_weight](solver::Job& job) -> std::function<void ()> {
+
+			auto optimum = solver::PartialAssignment();
+			int64_t weight = 0;
+			auto result = alpha::optimise(expr, vars, pins, weights, maximise, &optimum, &weight, job);
+
+			delete expr;
+			return [&job, result, weight, optimum = std::move(optimum)]() mutable {
+				if(solver_state.optimiseJob.get() != &job)
+					return;
+
+				solver_state.optimiseJob = nullptr;
+				if(result == solver::Sat::RESULT_UNKNOWN)
+					return;
+
+				solver_state.optimised = true;
+				solver_state.optimumFound = (result == solver::Sat::RESULT_SAT);
+				solver_state.optimum = std::move(optimum);
+				solver_state.optimumWeight = weight;
+
+				if(solver_state.optimumFound)
+					lg::log("solver", "optimum: weight {}", weight);
+			};
+		});
+	}
+
+	// an estimate has no business showing all of its digits.
+	static std::string estimate_string(const solver::BigNum& n)
+	{
+		if(n < solver::BigNum(1000000))
+			return n.str();
+
+		return zpr::sprint("{.2e}", n.f64());
+	}
+
+	static void start_check(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		solver_state.checked = false;
+		solver_state.checkJob = jobs.start([graph, expr = graph->expr(), vars = found_variables(),
+			pins](solver::Job& job) -> std::function<void ()> {
+
+			auto counterexample = solver::PartialAssignment();
+			auto result = alpha::find_counterexample(expr, vars, pins, &counterexample, job);
+
+			delete expr;
+			return [&job, graph, result, counterexample = std::move(counterexample)]() {
+				if(solver_state.checkJob.get() != &job)
+					return;
+
+				solver_state.checkJob = nullptr;
+				if(result == solver::Cursor::STEP_ABORTED)
+					return;
+
+				solver_state.checked = true;
+				solver_state.valid = (result == solver::Cursor::STEP_END);
+				solver_state.counterexample = counterexample;
+
+				if(solver_state.valid)
+				{
+					ui::logMessage("valid", 5);
+				}
+				else
+				{
+					show_assignment(graph, counterexample);
+					ui::logMessage("not valid; showing a counterexample", 5);
+				}
+			};
+		});
+	}
+
+	static void start_compare(Graph* graph)
+	{
+		auto parsed = parser::parse(zbuf::str_view((const char*) compare_buffer));
+		if(!parsed)
+		{
+			ui::logMessage(zpr::sprint("parse error: {}", parsed.error().msg), 5);
+			return;
+		}
+
+		auto raw = parsed.unwrap();
+		auto other = alpha::toAndNot(raw);
+		delete raw;
+
+		auto names = std::set<std::string>();
+		find_variables(other, names);
+
+		auto vars = found_variables();
+		for(auto& name : names)
+		{
+			if(!std::binary_search(found_variables().begin(), found_variables().end(), name))
+				vars.push_back(name);
+		}
+
+		solver_state.compared = false;
+		solver_state.compareJob = jobs.start([graph, expr = graph->expr(), other,
+			vars](solver::Job& job) -> std::function<void ()> {
+
+			auto difference = solver::PartialAssignment();
+			auto result = alpha::check_equivalent(expr, other, vars, &difference, job);
+
+			delete expr;
+			delete other;
+
+			return [&job, graph, result, vars, difference = std::move(difference)]() {
+				if(solver_state.compareJob.get() != &job)
+					return;
+
+				solver_state.compareJob = nullptr;
+				if(result == solver::EQUIV_UNKNOWN)
+					return;
+
+				solver_state.compared = true;
+				solver_state.equivalent = (result == solver::EQUIV_SAME);
+				solver_state.difference = difference;
+				solver_state.compareVars = vars;
+
+				if(solver_state.equivalent)
+				{
+					ui::logMessage("equivalent", 5);
+				}
+				else
+				{
+					show_assignment(graph, difference);
+					ui::logMessage("not equivalent; showing where they differ", 5);
+				}
+			};
+		});
+	}
+
+	static void start_cover(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		solver_state.covered = false;
+		solver_state.cubes.clear();
+		solver_state.selectedCube = -1;
+		solver_state.coverPins = pins;
+
+		solver_state.coverJob = jobs.start([expr = graph->expr(), vars = found_variables(),
+			pins](solver::Job& job) -> std::function<void ()> {
+
+			auto cubes = std::vector<solver::PartialAssignment>();
+			bool complete = false;
+			bool ok = alpha::find_cover(expr, vars, pins, &cubes, &complete, job);
+
+			delete expr;
+			return [&job, ok, complete, cubes = std::move(cubes)]() mutable {
+				if(solver_state.coverJob.get() != &job)
+					return;
+
+				solver_state.coverJob = nullptr;
+				if(!ok)
+					return;
+
+				solver_state.covered = true;
+				solver_state.coverComplete = complete;
+				solver_state.cubes = std::move(cubes);
+
+				auto n = solver_state.cubes.size();
+				lg::log("solver", "cover: {} cube{}", n, n == 1 ? "" : "s");
+				ui::logMessage(zpr::sprint("{}{} cube{}", n, complete ? "" : "+", n == 1 ? "" : "s"), 5);
+			};
+		});
+	}
+
+	static void start_stats(Graph* graph, const solver::PartialAssignment& pins)
+	{
+		solver_state.analysed = false;
+		solver_state.statsJob = jobs.start([expr = graph->expr(), vars = found_variables(),
+			pins](solver::Job& job) -> std::function<void ()> {
+
+			auto backbone = solver::PartialAssignment();
+			auto result = alpha::find_backbone(expr, vars, pins, &backbone, job);
+
+			auto counts = std::vector<solver::BigNum>();
+			auto total = solver::BigNum();
+			bool counted = false;
+
+			// the backbone is the same in every solution, so pinning it doesn't change the counts.
+			if(result == solver::Sat::RESULT_SAT)
+				counted = alpha::count_marginals(expr, vars, backbone, &counts, &total, job);
+
+			delete expr;
+			return [&job, result, counted, backbone = std::move(backbone), counts = std::move(counts),
+				total = std::move(total)]() mutable {
+
+				if(solver_state.statsJob.get() != &job)
+					return;
+
+				solver_state.statsJob = nullptr;
+				if(result == solver::Sat::RESULT_UNKNOWN)
+					return;
+
+				solver_state.analysed = true;
+				solver_state.satisfiable = (result == solver::Sat::RESULT_SAT);
+				solver_state.backbone = std::move(backbone);
+				solver_state.marginalsCounted = counted;
+				solver_state.trueCounts = std::move(counts);
+				solver_state.totalCount = std::move(total);
+			};
+		});
+	}
+
+	// only the variables that the cube decides; the ones that were pinned are in every cube anyway.
+	static std::string cube_string(const solver::PartialAssignment& cube)
+	{
+		auto ret = std::string();
+		for(size_t i = 0; i < cube.size() && i < found_variables().size(); i++)
+		{
+			if(!cube.isAssigned(i) || solver_state.coverPins.isAssigned(i))
+				continue;
+
+			ret += zpr::sprint("{}{}{}", ret.empty() ? "" : " ", cube.get(i) ? "" : "¬", found_variables()[i]);
+		}
+
+		return ret.empty() ? "(anything)" : ret;
+	}
+
+	static void select_cube(Graph* graph, int idx)
+	{
+		solver_state.selectedCube = idx;
+		var_assigns() = solver_state.cubes[(size_t) idx];
+		refresh_assignments(graph, /* everything: */ true);
+	}
+
+	// the variables in the other expression that aren't in ours can't be shown on the graph.
+	static std::string difference_string()
+	{
+		auto ret = std::string();
+		for(size_t i = found_variables().size(); i < solver_state.compareVars.size(); i++)
+		{
+			ret += zpr::sprint("{}{} = {}", ret.empty() ? "" : ", ", solver_state.compareVars[i],
+				solver_state.difference.get(i) ? 1 : 0);
+		}
+
+		return ret;
+	}
+
+	static std::string rate_string(double rate)
+	{
+		if(rate >= 1e9) return zpr::sprint("{.1f}G", rate / 1e9);
+		if(rate >= 1e6) return zpr::sprint("{.1f}M", rate / 1e6);
+		if(rate >= 1e3) return zpr::sprint("{.1f}k", rate / 1e3);
+
+		return zpr::sprint("{.0f}", rate);
+	}
+
+	static std::string time_string(double secs)
+	{
+		auto s = (uint64_t) secs;
+		if(s < 60)      return zpr::sprint("{}s", s);
+		if(s < 3600)    return zpr::sprint("{}m {}s", s / 60, s % 60);
+		if(s < 86400)   return zpr::sprint("{}h {}m", s / 3600, (s / 60) % 60);
+
+		return zpr::sprint("{}d {}h", s / 86400, (s / 3600) % 24);
+	}
+
+	// the speed only means something if the progress is in assignments; the bdd counts conjuncts.
+	static void show_progress(const solver::Job& job, const char* what, bool show_rate)
+	{
+		auto [ done, total ] = job.progress();
+		if(total == 0)
+		{
+			// the sat engine (and counting) can't tell how far along they are
+			imgui::ProgressBar(0, lx::vec2(0, 0), zpr::sprint("{} {}", what, time_string(job.elapsed())).c_str());
+			return;
+		}
+
+		double prog = (double) std::min(done, total) / (double) total;
+		auto label = zpr::sprint("{.1f}%", 100 * prog);
+
+		if(auto r = job.rate(); show_rate && r > 0)
+			label += zpr::sprint(", {}/s", rate_string(r));
+
+		if(auto eta = job.remaining(); eta >= 0)
+			label += zpr::sprint(", {} left", time_string(eta));
+
+		imgui::ProgressBar(prog, lx::vec2(0, 0), label.c_str());
+	}
+
+	static void cube_list(Graph* graph)
+	{
+		auto& theme = ui::theme();
+		auto& cubes = solver_state.cubes;
+
+		{
+			auto s = Styler();
+			s.push(ImGuiCol_Text, cubes.empty() ? theme.boxSelection : theme.boxDropTarget);
+
+			imgui::NewLine();
+			imgui::SameLine(0, 4);
+			if(cubes.empty())
+				imgui::TextUnformatted("unsatisfiable");
+			else
+				imgui::TextUnformatted(zpr::sprint("{}{} cube{}", cubes.size(), solver_state.coverComplete ? "" : "+",
+					cubes.size() == 1 ? "" : "s").c_str());
+		}
+
+		if(cubes.empty())
+			return;
+
+		auto height = std::min(cubes.size(), (size_t) 6) * imgui::GetTextLineHeightWithSpacing() + 8;
+		imgui::BeginChild("__cubes", lx::vec2(0, height), /* border: */ true);
+
+		// there can be a lot of them, so only the visible ones get drawn.
+		auto clipper = ImGuiListClipper();
+		clipper.Begin((int) cubes.size());
+		while(clipper.Step())
+		{
+			for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				auto label = zpr::sprint("{}##{}", cube_string(cubes[(size_t) i]), i);
+				if(imgui::Selectable(label.c_str(), solver_state.selectedCube == i))
+					select_cube(graph, i);
+			}
+		}
+
+		imgui::EndChild();
+	}
+
+	static void stats_view()
+	{
+		auto& theme = ui::theme();
+		if(!solver_state.satisfiable)
+		{
+			auto s = Styler();
+			s.push(ImGuiCol_Text, theme.boxSelection);
+
+			imgui::NewLine();
+			imgui::SameLine(0, 4);
+			imgui::TextUnformatted("unsatisfiable");
+			return;
+		}
+
+		auto& backbone = solver_state.backbone;
+		auto height = std::min(found_variables().size(), (size_t) 8) * imgui::GetFrameHeightWithSpacing() + 8;
+		imgui::BeginChild("__stats", lx::vec2(0, height), /* border: */ true);
+
+		auto total = solver_state.totalCount.f64();
+		for(size_t i = 0; i < found_variables().size() && i < backbone.size(); i++)
+		{
+			imgui::TextUnformatted(found_variables()[i].c_str());
+			imgui::SameLine(80);
+
+			auto s = Styler();
+			if(backbone.isAssigned(i))
+				s.push(ImGuiCol_Text, theme.boxDropTarget);
+
+			// without the counts we only know about the backbone.
+			double frac = 0;
+			auto label = std::string("?");
+			if(backbone.isAssigned(i))
+			{
+				frac = backbone.get(i) ? 1 : 0;
+				label = zpr::sprint("always {}", backbone.get(i) ? 1 : 0);
+			}
+			else if(solver_state.marginalsCounted && total > 0)
+			{
+				frac = solver_state.trueCounts[i].f64() / total;
+				label = zpr::sprint("{.1f}%", 100 * frac);
+			}
+
+			imgui::ProgressBar((float) frac, lx::vec2(-1, 0), label.c_str());
+		}
+
+		imgui::EndChild();
+	}
+
+	void solver_tool(Graph* graph)
+	{
+		auto& theme = ui::theme();
+
+		// hand over the results of anything that finished since the last frame.
+		jobs.poll();
+
+		imgui::PushID("__scope_solve");
+
+		imgui::Text("solver");
+		imgui::Indent();
+
+		// tasks
+		{
+			auto solving = (solver_state.solveJob != nullptr);
+			auto counting = (solver_state.countJob != nullptr);
+			auto estimating = (solver_state.estimateJob != nullptr);
+			auto checking = (solver_state.checkJob != nullptr);
+			auto comparing = (solver_state.compareJob != nullptr);
+			auto covering = (solver_state.coverJob != nullptr);
+			auto analysing = (solver_state.statsJob != nullptr);
+			auto optimising = (solver_state.optimiseJob != nullptr);
+			{
+				auto s = disabled_style(solving);
+				auto ss = Styler();
+				ss.push(ImGuiCol_FrameBg, theme.textFieldBg);
+
+				// there's no fork() on the web.
+				#if !defined(__EMSCRIPTEN__)
+					const char* engines[] = { "serial", "parallel", "sat", "bdd", "gray code", "sample", "processes" };
+				#else
+					const char* engines[] = { "serial", "parallel", "sat", "bdd", "gray code", "sample" };
+				#endif
+
+				imgui::SetNextItemWidth(120);
+				imgui::Combo("engine", &solver_engine, engines, (int) (sizeof(engines) / sizeof(engines[0])));
+
+				if(solver_engine == ENGINE_SAMPLE)
+				{
+					imgui::SetNextItemWidth(120);
+					if(imgui::InputInt("samples", &sample_count, 0))
+						sample_count = std::clamp(sample_count, 1, MAX_SAMPLES);
+				}
+			}
+
+			// pinned variables aren't enumerated, so they don't count against the limit.
+			auto pins = user_pins();
+			auto num_free = found_variables().size() - std::min(found_variables().size(), num_pinned(pins));
+
+			{
+				// projecting always uses the sat solver; see start_solve().
+				bool brute_force = is_brute_force(solver_engine) && current_projection().empty();
+
+				// the shortcut has to be refused too, not just the button.
+				bool too_many = brute_force && num_free > solver::MAX_BRUTE_FORCE_VARS;
+				bool blocked = solving || too_many;
+
+				if(solve_requested && too_many)
+				{
+					solve_requested = false;
+					ui::logMessage("too many variables to brute-force; try the sat engine", 5);
+				}
+
+				auto s = disabled_style(blocked);
+				auto ss = flash_style(SB_BUTTON_V_SOLVE);
+				if((imgui::Button("s \uf0ae solve ") || solve_requested) && !blocked)
+				{
+					solve_requested = false;
+
+					// put away the results of the last solve, which might be from another engine.
+					reset_soln(/* keep_jobs: */ true);
+
+					// every solve draws new samples.
+					if(solver_engine != ENGINE_SAMPLE && restore_soln(graph, pins) && solver_state.cursor != nullptr)
+						lg::log("solver", "using cached results");
+					else
+						start_solve(graph, pins, num_free, brute_force);
+				}
+			}
+
+			imgui::SameLine();
+
+			// a count can run alongside a solve, as long as they're for the same thing.
+			{
+				auto s = disabled_style(counting);
+				if(imgui::Button(" \uf1ec count ") && !counting)
+					start_count(graph, pins);
+			}
+
+			imgui::SameLine();
+
+			// a full solve would go through every satisfying assignment to show that there's no
+			// falsifying one, so this goes looking for a falsifying one directly.
+			{
+				auto s = disabled_style(checking);
+				if(imgui::Button(" \uf00c check ") && !checking)
+					start_check(graph, pins);
+			}
+
+			// a long search from before (maybe before a restart) can carry on from where it got to.
+			if(have_saved_search && !solving && !solver_state.did_solve)
+			{
+				if(imgui::Button(" \uf01e resume search "))
+				{
+					reset_soln(/* keep_jobs: */ true);
+					start_solve(graph, pins, num_free, /* brute_force: */ true, &saved_search);
+				}
+
+				if(saved_search.cursor.hasCurrent)
+				{
+					imgui::SameLine();
+					imgui::TextUnformatted(zpr::sprint("from #{}", saved_search.cursor.position + 1).c_str());
+				}
+			}
+
+			// a few cubes say much more than thousands of solutions, one at a time.
+			{
+				auto s = disabled_style(covering);
+				if(imgui::Button(" \uf00a cubes ") && !covering)
+					start_cover(graph, pins);
+			}
+
+			imgui::SameLine();
+
+			{
+				auto s = disabled_style(analysing);
+				if(imgui::Button(" \uf080 stats ") && !analysing)
+					start_stats(graph, pins);
+			}
+
+			imgui::SameLine();
+
+			// for when counting exactly would take forever.
+			{
+				auto s = disabled_style(estimating);
+				if(imgui::Button(" \u2248 estimate ") && !estimating)
+					start_estimate(graph, pins);
+			}
+
+			// the weights are next to the variables.
+			{
+				auto s = Styler();
+				s.push(ImGuiCol_FrameBg, theme.textFieldBg);
+
+				const char* goals[] = { "min weight", "max weight" };
+				int goal = maximise_weight ? 1 : 0;
+
+				imgui::SetNextItemWidth(120);
+				if(imgui::Combo("##goal", &goal, goals, 2))
+				{
+					maximise_weight = (goal == 1);
+					forget_optimum();
+				}
+
+				imgui::SameLine();
+
+				auto ss = disabled_style(optimising);
+				if(imgui::Button(" \uf201 optimise ") && !optimising)
+					start_optimise(graph, pins);
+			}
+
+			// equivalence doesn't care about the pins, since it's about every assignment.
+			{
+				auto s = Styler();
+				s.push(ImGuiCol_FrameBg, theme.textFieldBg);
+
+				imgui::SetNextItemWidth(140);
+				bool submit = imgui::InputTextWithHint("##compare", "compare with", compare_buffer, COMPARE_BUFFER_SIZE,
+					ImGuiInputTextFlags_EnterReturnsTrue);
+
+				imgui::SameLine();
+
+				auto ss = disabled_style(comparing);
+				if((imgui::Button(" \uf0ec ") || submit) && !comparing)
+					start_compare(graph);
+			}
+
+			if(solving && solver_state.did_solve)
+				show_progress(*solver_state.solveJob, "searching...", is_brute_force(solver_state.engine));
+
+			if(counting)
+				show_progress(*solver_state.countJob, "counting...", /* show_rate: */ false);
+
+			if(estimating)
+				show_progress(*solver_state.estimateJob, "estimating...", /* show_rate: */ false);
+
+			if(checking)
+				show_progress(*solver_state.checkJob, "checking...", /* show_rate: */ false);
+
+			if(comparing)
+				show_progress(*solver_state.compareJob, "comparing...", /* show_rate: */ false);
+
+			if(covering)
+				show_progress(*solver_state.coverJob, "covering...", /* show_rate: */ false);
+
+			if(analysing)
+				show_progress(*solver_state.statsJob, "analysing...", /* show_rate: */ false);
+
+			if(optimising)
+				show_progress(*solver_state.optimiseJob, "optimising...", /* show_rate: */ false);
+
+			// keep drawing while something is running, so the progress moves and the results get
+			// picked up as soon as they're ready.
+			if(solving || counting || estimating || checking || comparing || covering || analysing || optimising)
+				ui::continueDrawing();
+
+			if(!solving && solver_state.did_solve && solver_state.cursor != nullptr)
+			{
+				auto cursor = solver_state.cursor;
+				if(!have_solution() && cursor->hasNext())
+				{
+					// the search was aborted before it found anything, so we don't know anything.
+					solver_state.did_solve = false;
+				}
+				else if(!have_solution())
+				{
+					auto s = Styler();
+					s.push(ImGuiCol_Text, theme.boxSelection);
+
+					imgui::NewLine();
+					imgui::SameLine(0, 4);
+					imgui::Text("unsatisfiable");
+				}
+				else
+				{
+					{
+						auto s = Styler();
+						s.push(ImGuiCol_Text, theme.boxDropTarget);
+
+						imgui::NewLine();
+						imgui::SameLine(0, 4);
+						imgui::TextUnformatted(solution_count_string().c_str());
+
+						// every assignment (of the free variables) is a solution
+						auto num_free = num_enumerated(solver_state.pins, solver_state.projection);
+						if(auto n = solver::BigNum(); cursor->count(&n) && n == solver::BigNum(1) << num_free)
+						{
+							imgui::SameLine();
+							imgui::TextUnformatted("(valid)");
+						}
+					}
+
+					{
+						auto s = disabled_style(!cursor->hasPrev());
+						auto ss = flash_style(SB_BUTTON_V_PREV_SOLN);
+						if(imgui::Button("\uf177 prev ") && cursor->hasPrev())
+							start_step(/* forward: */ false);
+					}
+
+					imgui::SameLine();
+
+					{
+						auto s = disabled_style(!cursor->hasNext());
+						auto ss = flash_style(SB_BUTTON_V_NEXT_SOLN);
+						if(imgui::Button(" next \uf178") && cursor->hasNext())
+							start_step(/* forward: */ true);
+					}
+
+					imgui::SameLine();
+					imgui::TextUnformatted(zpr::sprint("#{}", cursor->index() + 1).c_str());
+
+					// a step just finished, so show where it ended up.
+					if(solver_state.waiting)
+					{
+						solver_state.waiting = false;
+
+						var_assigns() = get_solution();
+						set_flags(graph, var_assigns());
+					}
+				}
+			}
+
+			if(!counting && solver_state.counted)
+			{
+				auto s = Styler();
+				s.push(ImGuiCol_Text, theme.boxDropTarget);
+
+				auto& count = solver_state.count;
+				imgui::NewLine();
+				imgui::SameLine(0, 4);
+				imgui::TextUnformatted(zpr::sprint("{} model{}", count.str(), count == solver::BigNum(1) ? "" : "s").c_str());
+
+				if(count == solver::BigNum(1) << num_free)
+				{
+					imgui::SameLine();
+					imgui::TextUnformatted("(valid)");
+				}
+			}
+
+			if(!estimating && solver_state.estimated)
+			{
+				auto s = Styler();
+				s.push(ImGuiCol_Text, theme.boxDropTarget);
+
+				auto& n = solver_state.estimate;
+				auto models = zpr::sprint("model{}", n == solver::BigNum(1) ? "" : "s");
+
+				imgui::NewLine();
+				imgui::SameLine(0, 4);
+				if(solver_state.estimateExact)
+				{
+					imgui::TextUnformatted(zpr::sprint("{} {} (exact)", n.str(), models).c_str());
+				}
+				else
+				{
+					imgui::TextUnformatted(zpr::sprint("\u2248 {} {} (\u00b1{.0f}%, {.0f}% confidence)", estimate_string(n), models,
+						100 * APPROX_EPSILON, 100 * (1 - APPROX_DELTA)).c_str());
+				}
+			}
+
+			if(!checking && solver_state.checked)
+			{
+				{
+					auto s = Styler();
+					s.push(ImGuiCol_Text, solver_state.valid ? theme.boxDropTarget : theme.boxSelection);
+
+					imgui::NewLine();
+					imgui::SameLine(0, 4);
+					imgui::TextUnformatted(solver_state.valid ? "valid" : "not valid");
+				}
+
+				// the flags get redrawn when anything changes, so let the counterexample come back.
+				if(!solver_state.valid)
+				{
+					imgui::SameLine();
+					if(imgui::Button(" counterexample "))
+						show_assignment(graph, solver_state.counterexample);
+				}
+			}
+
+			if(!optimising && solver_state.optimised)
+			{
+				{
+					auto s = Styler();
+					s.push(ImGuiCol_Text, solver_state.optimumFound ? theme.boxDropTarget : theme.boxSelection);
+
+					imgui::NewLine();
+					imgui::SameLine(0, 4);
+					imgui::TextUnformatted(solver_state.optimumFound
+						? zpr::sprint("{} weight: {}", maximise_weight ? "max" : "min", solver_state.optimumWeight).c_str()
+						: "unsatisfiable");
+				}
+
+				if(solver_state.optimumFound)
+				{
+					imgui::SameLine();
+					if(imgui::Button(" show "))
+						show_assignment(graph, solver_state.optimum);
+				}
+			}
+
+			if(!comparing && solver_state.compared)
+			{
+				{
+					auto s = Styler();
+					s.push(ImGuiCol_Text, solver_state.equivalent ? theme.boxDropTarget : theme.boxSelection);
+
+					imgui::NewLine();
+					imgui::SameLine(0, 4);
+					imgui::TextUnformatted(solver_state.equivalent ? "equivalent" : "not equivalent");
+				}
+
+				if(!solver_state.equivalent)
+				{
+					imgui::SameLine();
+					if(imgui::Button(" difference "))
+						show_assignment(graph, solver_state.difference);
+
+					if(auto extra = difference_string(); !extra.empty())
+					{
+						imgui::NewLine();
+						imgui::SameLine(0, 4);
+						imgui::TextUnformatted(zpr::sprint("with {}", extra).c_str());
+					}
+				}
+			}
+
+			if(!covering && solver_state.covered)
+				cube_list(graph);
+
+			if(!analysing && solver_state.analysed)
+				stats_view();
+		}
+
+		imgui::Unindent();
+		imgui::PopID();
+	}
+
+	// used by interact.cpp
+	void prev_solution(Graph* graph)
+	{
+		if(solver_state.solveJob != nullptr || !have_solution())
+			return;
+
+		if(solver_state.cursor->hasPrev())
+			start_step(/* forward: */ false);
+	}
+
+	void next_solution(Graph* graph)
+	{
+		if(solver_state.solveJob != nullptr || !have_solution())
+			return;
+
+		if(solver_state.cursor->hasNext())
+			start_step(/* forward: */ true);
+	}
+
+	void solve_expression()
+	{
+		solve_requested = true;
+	}
+
+	// the jobs still hand back what they had, so an interrupted solve can carry on later.
+	void pause_solving()
+	{
+		if(solver_state.solveJob != nullptr)
+			solver_state.solveJob->cancel();
+
+		for(auto& job : { solver_state.countJob, solver_state.estimateJob, solver_state.checkJob, solver_state.compareJob,
+			solver_state.coverJob, solver_state.statsJob, solver_state.optimiseJob })
+		{
+			if(job != nullptr)
+				job->cancel();
+		}
+	}
+
+	void stopSolving()
+	{
+		jobs.stop();
+	}
+}
@@ -232,6 +232,9 @@ namespace ui
 
 	void stop()
 	{
+		// the solver threads hand their results to the sidebar, so they have to be gone first.
+		ui::stopSolving();
+
 		ImGui_ImplOpenGL3_Shutdown();
 		ImGui_ImplSDL2_Shutdown();
 		ImGui::DestroyContext();
@@ -2,58 +2,728 @@
 // Copyright (c) 2021, zhiayang
 // Licensed under the Apache License Version 2.0.
 
-#include <set>
 #include <unordered_map>
 
 #include "ui.h"
 #include "ast.h"
+#include "solver.h"
 
 namespace alpha
 {
-	using Assignment = std::unordered_map<std::string, bool>;
+	// moves the cursor one solution forwards or backwards; returns one of the Cursor::STEP_* values.
+	int step_solver(solver::Cursor* cursor, bool forward, solver::Job& job)
+	{
+		// the bdd and sat engines can't tell how far along they are.
+		job.setProgress(0, 0);
+
+		cursor->interrupt = job.interruptor();
+		cursor->progress = job.reporter();
+
+		auto ret = forward ? cursor->next() : cursor->prev();
+
+		// the job goes away after this, so don't leave anything pointing at it.
+		cursor->interrupt = nullptr;
+		cursor->progress = nullptr;
 
-	static volatile bool should_abort = false;
-	void abort_solve()
+		return ret;
+	}
+
+	static bool any_pinned(const solver::PartialAssignment& pins)
 	{
-		__atomic_store_n(&should_abort, true, __ATOMIC_SEQ_CST);
+		for(auto w : pins.assigned.words)
+		{
+			if(w != 0)
+				return true;
+		}
+
+		return false;
 	}
 
-	std::vector<Assignment> generate_solutions(ast::Expr* expr, const std::set<std::string>& vars,
-		std::pair<size_t, size_t>& progress)
+	// the sheet is an and of everything on it, and double cuts don't get in the way.
+	static void top_level_conjuncts(ast::Expr* expr, std::vector<ast::Expr*>& out)
 	{
-		// cancel any pending aborts
-		__atomic_store_n(&should_abort, false, __ATOMIC_SEQ_CST);
+		if(auto a = dynamic_cast<ast::And*>(expr); a != nullptr)
+		{
+			top_level_conjuncts(a->left, out);
+			top_level_conjuncts(a->right, out);
+		}
+		else if(auto n = dynamic_cast<ast::Not*>(expr); n != nullptr && dynamic_cast<ast::Not*>(n->e) != nullptr)
+		{
+			top_level_conjuncts(static_cast<ast::Not*>(n->e)->e, out);
+		}
+		else
+		{
+			out.push_back(expr);
+		}
+	}
 
-		std::vector<Assignment> solns;
-		progress.second = (1 << vars.size());
+	// what the caller wants out of the expression, which decides what preprocess() may throw away.
+	static constexpr int GOAL_ALL       = 0;    // every solution (enumerating, covering, sampling, counting)
+	static constexpr int GOAL_ANY       = 1;    // any one solution
+	static constexpr int GOAL_CHEAPEST  = 2;    // a solution of least weight
 
-		// uwu.
-		for(size_t i = 0; i < progress.second; i++)
+	// which way round each variable appears: bit 0 if it's inside an even number of cuts, bit 1 if odd.
+	// returns false if there's something other than a variable, a literal, a cut, or an and.
+	static bool polarities_of(const ast::Expr* expr, bool cut, const std::unordered_map<std::string, size_t>& indices,
+		std::vector<uint8_t>& out)
+	{
+		if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			if(auto it = indices.find(v->name); it != indices.end())
+				out[it->second] |= (cut ? 2 : 1);
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			return polarities_of(n->e, !cut, indices, out);
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			return polarities_of(a->left, cut, indices, out) && polarities_of(a->right, cut, indices, out);
+		}
+		else if(dynamic_cast<const ast::Lit*>(expr) == nullptr)
 		{
-			if(__atomic_load_n(&should_abort, __ATOMIC_SEQ_CST))
+			return false;
+		}
+
+		return true;
+	}
+
+	// a variable that only appears one way round can be set that way without losing every solution, and
+	// one that doesn't appear can be anything. for GOAL_CHEAPEST, only if its cost doesn't go up.
+	static size_t fix_pure_literals(const ast::Expr* expr, const std::vector<std::string>& vars,
+		const std::unordered_map<std::string, size_t>& indices, int goal, const std::vector<int64_t>* costs,
+		solver::PartialAssignment& forced, std::unordered_map<std::string, bool>& syms)
+	{
+		auto polarity = std::vector<uint8_t>(vars.size());
+		if(!polarities_of(expr, false, indices, polarity))
+			return 0;
+
+		size_t count = 0;
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			if(forced.isAssigned(i) || polarity[i] == 3)
+				continue;
+
+			auto cost = (goal == GOAL_CHEAPEST) ? (*costs)[i] : 0;
+
+			bool value;
+			if(polarity[i] == 0)        value = (cost < 0);
+			else if(polarity[i] == 1)   value = true;
+			else                        value = false;
+
+			if((value && cost > 0) || (!value && cost < 0))
+				continue;
+
+			forced.set(i, value);
+			syms[vars[i]] = value;
+			count += 1;
+		}
+
+		return count;
+	}
+
+	// substitutes the pins, then pins whatever the sheet forces (a variable alone on the sheet, or alone
+	// in a cut on it) until nothing changes; pure literals too, unless `goal` is GOAL_ALL, since that
+	// would lose solutions. free_vars keep their order from `vars`; the caller owns the result.
+	static ast::Expr* preprocess(ast::Expr* expr, const std::vector<std::string>& vars, int goal,
+		const std::vector<int64_t>* costs, solver::PartialAssignment& forced, std::vector<std::string>& free_vars)
+	{
+		if(forced.size() != vars.size())
+			forced = solver::PartialAssignment(vars.size());
+
+		auto indices = std::unordered_map<std::string, size_t>();
+		auto syms = std::unordered_map<std::string, bool>();
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			indices[vars[i]] = i;
+			if(forced.isAssigned(i))
+				syms[vars[i]] = forced.get(i);
+		}
+
+		size_t num_units = 0;
+		size_t num_pure = 0;
+		auto residual = expr->evaluate(syms);
+		while(true)
+		{
+			auto conjuncts = std::vector<ast::Expr*>();
+			top_level_conjuncts(residual, conjuncts);
+
+			syms.clear();
+			for(auto c : conjuncts)
 			{
-				should_abort = false;
+				auto value = true;
+				auto v = dynamic_cast<ast::Var*>(c);
+				if(auto n = dynamic_cast<ast::Not*>(c); n != nullptr)
+					v = dynamic_cast<ast::Var*>(n->e), value = false;
+
+				// if the same variable is forced both ways, substituting either one gives us the empty cut.
+				if(v == nullptr || syms.find(v->name) != syms.end())
+					continue;
+
+				if(auto it = indices.find(v->name); it != indices.end())
+				{
+					forced.set(it->second, value);
+					syms[v->name] = value;
+				}
+			}
+
+			auto units = syms.size();
+			if(units == 0 && goal != GOAL_ALL)
+				num_pure += fix_pure_literals(residual, vars, indices, goal, costs, forced, syms);
+
+			if(syms.empty())
 				break;
+
+			num_units += units;
+
+			auto next = residual->evaluate(syms);
+			delete residual;
+			residual = next;
+		}
+
+		if(num_units > 0)
+			lg::log("solver", "preprocessing forced {} variable{}", num_units, num_units == 1 ? "" : "s");
+
+		if(num_pure > 0)
+			lg::log("solver", "preprocessing fixed {} pure literal{}", num_pure, num_pure == 1 ? "" : "s");
+
+		if(auto l = dynamic_cast<ast::Lit*>(residual); l != nullptr && !l->value)
+		{
+			for(size_t i = 0; i < vars.size(); i++)
+			{
+				if(!forced.isAssigned(i))
+					forced.set(i, false);
+			}
+		}
+
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			if(!forced.isAssigned(i))
+				free_vars.push_back(vars[i]);
+		}
+
+		return residual;
+	}
+
+	// what's left of the problem after preprocessing, over just the free variables; the caller owns `expr`.
+	struct Residual
+	{
+		ast::Expr* expr = nullptr;
+		solver::PartialAssignment forced;
+		std::vector<std::string> freeVars;
+
+		// where each of the free variables is in the original list.
+		std::vector<size_t> freeIndices;
+
+		// puts (some of) the free variables back with the forced ones.
+		solver::PartialAssignment expand(const solver::PartialAssignment& free) const
+		{
+			auto ret = this->forced;
+			for(size_t k = 0; k < this->freeIndices.size(); k++)
+			{
+				if(free.isAssigned(k))
+					ret.set(this->freeIndices[k], free.get(k));
+			}
+
+			return ret;
+		}
+	};
+
+	static Residual reduce(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		int goal = GOAL_ALL, const std::vector<int64_t>* costs = nullptr)
+	{
+		auto ret = Residual();
+		ret.forced = pins;
+		ret.expr = preprocess(expr, vars, goal, costs, ret.forced, ret.freeVars);
+
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			if(!ret.forced.isAssigned(i))
+				ret.freeIndices.push_back(i);
+		}
+
+		return ret;
+	}
+
+	static void variables_of(const ast::Expr* expr, const std::unordered_map<std::string, size_t>& indices,
+		std::vector<size_t>& out)
+	{
+		if(auto v = dynamic_cast<const ast::Var*>(expr); v != nullptr)
+		{
+			if(auto it = indices.find(v->name); it != indices.end())
+				out.push_back(it->second);
+		}
+		else if(auto n = dynamic_cast<const ast::Not*>(expr); n != nullptr)
+		{
+			variables_of(n->e, indices, out);
+		}
+		else if(auto a = dynamic_cast<const ast::And*>(expr); a != nullptr)
+		{
+			variables_of(a->left, indices, out);
+			variables_of(a->right, indices, out);
+		}
+	}
+
+	using CursorMaker = std::function<solver::Cursor* (ast::Expr*, const std::vector<std::string>&)>;
+
+	// top-level cuts that share no variables get solved separately; returns null if any part failed.
+	static solver::Cursor* make_components(ast::Expr* expr, const std::vector<std::string>& vars,
+		const CursorMaker& make)
+	{
+		auto conjuncts = std::vector<ast::Expr*>();
+		top_level_conjuncts(expr, conjuncts);
+
+		if(conjuncts.size() < 2)
+			return make(expr, vars);
+
+		auto indices = std::unordered_map<std::string, size_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+			indices[vars[i]] = i;
+
+		auto parent = std::vector<size_t>(vars.size());
+		for(size_t i = 0; i < parent.size(); i++)
+			parent[i] = i;
+
+		auto find = [&parent](size_t v) -> size_t {
+			while(parent[v] != v)
+				v = parent[v] = parent[parent[v]];
+			return v;
+		};
+
+		auto conjunct_vars = std::vector<std::vector<size_t>>(conjuncts.size());
+		auto constrained = std::vector<bool>(vars.size(), false);
+		for(size_t c = 0; c < conjuncts.size(); c++)
+		{
+			variables_of(conjuncts[c], indices, conjunct_vars[c]);
+			for(auto v : conjunct_vars[c])
+			{
+				constrained[v] = true;
+				parent[find(v)] = find(conjunct_vars[c][0]);
+			}
+		}
+
+		// number the parts by their first variable; the unconstrained variables all go together.
+		auto group_of = std::vector<size_t>(vars.size(), SIZE_MAX);
+		auto part_vars = std::vector<std::vector<size_t>>();
+		size_t unconstrained = SIZE_MAX;
+
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			auto& g = constrained[i] ? group_of[find(i)] : unconstrained;
+			if(g == SIZE_MAX)
+			{
+				g = part_vars.size();
+				part_vars.emplace_back();
+			}
+
+			part_vars[g].push_back(i);
+		}
+
+		if(part_vars.size() < 2)
+			return make(expr, vars);
+
+		// constants don't have any variables, so they can go anywhere.
+		auto part_exprs = std::vector<ast::Expr*>(part_vars.size(), nullptr);
+		for(size_t c = 0; c < conjuncts.size(); c++)
+		{
+			auto g = conjunct_vars[c].empty() ? 0 : group_of[find(conjunct_vars[c][0])];
+			auto copy = conjuncts[c]->evaluate({ });
+
+			part_exprs[g] = part_exprs[g] ? new ast::And(part_exprs[g], copy) : copy;
+		}
+
+		auto parts = std::vector<solver::Cursor*>();
+		auto part_indices = std::vector<std::vector<uint32_t>>();
+		for(size_t g = 0; g < part_vars.size(); g++)
+		{
+			auto names = std::vector<std::string>();
+			auto& idxs = part_indices.emplace_back();
+			for(auto v : part_vars[g])
+			{
+				names.push_back(vars[v]);
+				idxs.push_back((uint32_t) v);
+			}
+
+			auto e = part_exprs[g] ? part_exprs[g] : new ast::Lit(true);
+			auto cursor = make(e, names);
+			delete e;
+
+			if(cursor == nullptr)
+			{
+				for(size_t k = g + 1; k < part_exprs.size(); k++)
+					delete part_exprs[k];
+
+				for(auto p : parts)
+					delete p;
+
+				return nullptr;
 			}
 
-			Assignment ass;
+			parts.push_back(cursor);
+		}
+
+		lg::log("solver", "split into {} independent parts", parts.size());
+		return solver::productCursor(std::move(parts), std::move(part_indices), vars.size());
+	}
+
+	// solves the free variables one part at a time, then fills in the pinned (and forced) ones.
+	static solver::Cursor* make_enumerator(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, const CursorMaker& make)
+	{
+		auto r = reduce(expr, vars, pins);
+		auto inner = make_components(r.expr, r.freeVars, make);
+		delete r.expr;
+
+		if(inner == nullptr || !any_pinned(r.forced))
+			return inner;
+
+		return solver::pinnedCursor(inner, r.forced);
+	}
+
+	// the values in the cursor are in the same order as `vars`.
+	solver::Cursor* make_brute_force_solver(ast::Expr* expr, const std::vector<std::string>& vars, bool parallel,
+		const solver::PartialAssignment& pins)
+	{
+		auto workers = parallel ? solver::numHardwareThreads() : 1;
+		return make_enumerator(expr, vars, pins, [workers](ast::Expr* e, const std::vector<std::string>& v) {
+			return solver::bruteForceCursor(e, v, workers);
+		});
+	}
+
+	// brute force, but in other processes; see solver::WorkerPool.
+	solver::Cursor* make_process_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, std::shared_ptr<solver::WorkerPool> pool)
+	{
+		return make_enumerator(expr, vars, pins, [pool](ast::Expr* e, const std::vector<std::string>& v) {
+			return solver::processCursor(e, v, pool);
+		});
+	}
+
+	solver::Cursor* make_gray_code_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins)
+	{
+		return make_enumerator(expr, vars, pins, [](ast::Expr* e, const std::vector<std::string>& v) {
+			return solver::grayCodeCursor(e, v);
+		});
+	}
+
+	// the sat solver takes the pins as assumptions, so it keeps the whole expression.
+	solver::Cursor* make_sat_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins)
+	{
+		return solver::satCursor(expr, vars, pins);
+	}
+
+	// one solution for each combination of the `shown` variables that can be made true; this
+	// needs blocking clauses over just those, so it's always the sat solver.
+	solver::Cursor* make_projected_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, const std::vector<bool>& shown)
+	{
+		return solver::projectedCursor(expr, vars, pins, shown);
+	}
+
+	// returns null if the bdd got too big, or if we were aborted. level i of the bdd is variable
+	// levels[i] of `vars`.
+	static solver::Bdd* build_bdd(ast::Expr* expr, const std::vector<std::string>& vars, solver::Job& job,
+		solver::Bdd::Node* root, std::vector<uint32_t>* levels)
+	{
+		// this usually gives a much smaller bdd than going alphabetically. variables that aren't in
+		// the expression at all still count towards the solutions.
+		*levels = solver::firstAppearanceOrder(expr, vars, /* everything: */ true);
+
+		// the results go back in the order of `vars`, not the bdd's order.
+		auto order = std::vector<std::string>();
+		for(auto v : *levels)
+			order.push_back(vars[v]);
+
+		auto bdd = new solver::Bdd(order.size());
+		bdd->interrupt = job.interruptor();
+		bdd->progress = job.reporter();
+		job.setProgress(0, 1);
+
+		bool ok = bdd->build(expr, order, root);
+
+		bdd->interrupt = nullptr;
+		bdd->progress = nullptr;
 
-			size_t k = 0;
-			for(auto& v : vars)
+		if(!ok)
+		{
+			delete bdd;
+			return nullptr;
+		}
+
+		lg::log("solver", "bdd: {} nodes", bdd->numNodes());
+		return bdd;
+	}
+
+	static solver::Cursor* build_bdd_cursor(ast::Expr* expr, const std::vector<std::string>& vars,
+		solver::Job& job)
+	{
+		auto root = solver::Bdd::FALSE;
+		auto levels = std::vector<uint32_t>();
+		if(auto bdd = build_bdd(expr, vars, job, &root, &levels); bdd != nullptr)
+			return solver::bddCursor(bdd, root, levels);
+
+		return nullptr;
+	}
+
+	// the bdd's cover is irredundant, so it's the one we want; returns false if the bdd got too big.
+	static bool bdd_cover(ast::Expr* expr, const std::vector<std::string>& vars,
+		std::vector<solver::PartialAssignment>* out, size_t max_cubes, solver::Job& job)
+	{
+		// variables that aren't in the expression never show up in a cube, so they can be left out.
+		auto levels = solver::firstAppearanceOrder(expr, vars, /* everything: */ false);
+
+		auto order = std::vector<std::string>();
+		for(auto v : levels)
+			order.push_back(vars[v]);
+
+		auto bdd = solver::Bdd(order.size());
+		bdd.interrupt = job.interruptor();
+
+		auto root = solver::Bdd::FALSE;
+		auto cubes = std::vector<solver::PartialAssignment>();
+		if(!bdd.build(expr, order, &root) || !bdd.cover(root, &cubes, max_cubes))
+			return false;
+
+		for(auto& c : cubes)
+		{
+			auto cube = solver::PartialAssignment(vars.size());
+			for(size_t lv = 0; lv < order.size(); lv++)
+			{
+				if(c.isAssigned(lv))
+					cube.set(levels[lv], c.get(lv));
+			}
+
+			out->push_back(std::move(cube));
+		}
+
+		return true;
+	}
+
+	// the solutions as prime cubes (unassigned means don't-care). returns false if cancelled; `complete`
+	// is false if there were too many to list.
+	bool find_cover(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		std::vector<solver::PartialAssignment>* out, bool* complete, solver::Job& job)
+	{
+		static constexpr size_t MAX_CUBES = 1 << 16;
+
+		auto r = reduce(expr, vars, pins);
+		auto cubes = std::vector<solver::PartialAssignment>();
+		bool ok = true;
+
+		// if there's an empty cut on the sheet, there's nothing to cover.
+		if(auto l = dynamic_cast<ast::Lit*>(r.expr); l == nullptr || l->value)
+		{
+			// ask for one more than we want, to find out if there would have been too many.
+			if(!bdd_cover(r.expr, r.freeVars, &cubes, MAX_CUBES + 1, job) && !job.isCancelled())
+			{
+				lg::log("solver", "bdd too large; covering with sat");
+
+				cubes.clear();
+				ok = solver::satCover(r.expr, r.freeVars, &cubes, MAX_CUBES + 1, job.interruptor());
+			}
+		}
+
+		delete r.expr;
+		if(!ok || job.isCancelled())
+			return false;
+
+		*complete = (cubes.size() <= MAX_CUBES);
+		if(!*complete)
+			cubes.resize(MAX_CUBES);
+
+		// the biggest cubes (with the fewest variables) first.
+		auto num_assigned = [](const solver::PartialAssignment& a) -> size_t {
+			size_t ret = 0;
+			for(auto w : a.assigned.words)
+				ret += __builtin_popcountll(w);
+
+			return ret;
+		};
+
+		std::stable_sort(cubes.begin(), cubes.end(), [&num_assigned](auto& a, auto& b) {
+			return num_assigned(a) < num_assigned(b);
+		});
+
+		out->clear();
+		for(auto& c : cubes)
+			out->push_back(r.expand(c));
+
+		return true;
+	}
+
+	// returns null if the bdd got too big, or if we were aborted.
+	solver::Cursor* make_bdd_solver(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, solver::Job& job)
+	{
+		return make_enumerator(expr, vars, pins, [&job](ast::Expr* e, const std::vector<std::string>& v) {
+			return build_bdd_cursor(e, v, job);
+		});
+	}
+
+	// `limit` random solutions: uniform from the bdd, or near-uniform with sat if it's too big. null if aborted.
+	solver::Cursor* make_sampler(ast::Expr* expr, const std::vector<std::string>& vars,
+		const solver::PartialAssignment& pins, size_t limit, solver::Job& job)
+	{
+		auto r = reduce(expr, vars, pins);
+		solver::Sampler* sampler = nullptr;
+
+		auto root = solver::Bdd::FALSE;
+		auto levels = std::vector<uint32_t>();
+		if(auto bdd = build_bdd(r.expr, r.freeVars, job, &root, &levels); bdd != nullptr)
+		{
+			sampler = solver::bddSampler(bdd, root, levels);
+		}
+		else if(!job.isCancelled())
+		{
+			lg::log("solver", "bdd too large; sampling with sat");
+			sampler = solver::xorSampler(r.expr, r.freeVars);
+		}
+
+		delete r.expr;
+		if(sampler == nullptr)
+			return nullptr;
+
+		auto seed = std::random_device();
+		return solver::sampleCursor(sampler, r.forced, limit, ((uint64_t) seed() << 32) | seed());
+	}
+
+	// counts the solutions without finding them; returns false if the job was cancelled.
+	bool count_models(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::BigNum* out, solver::Job& job)
+	{
+		auto r = reduce(expr, vars, pins);
+		bool ok = solver::countModels(r.expr, r.freeVars, out, job.interruptor());
+		delete r.expr;
+
+		return ok;
+	}
+
+	// an (epsilon, delta) estimate of the count, for when counting exactly would take forever; `exact`
+	// is set if there were few enough solutions to just count. returns false if the job was cancelled.
+	bool approx_count(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		double epsilon, double delta, solver::BigNum* out, bool* exact, solver::Job& job)
+	{
+		auto r = reduce(expr, vars, pins);
+		auto seed = std::random_device();
+		bool ok = solver::approxCount(r.expr, r.freeVars, epsilon, delta, ((uint64_t) seed() << 32) | seed(),
+			out, exact, job.interruptor(), job.reporter());
+
+		delete r.expr;
+		return ok;
+	}
+
+	// the solution with the smallest (or largest) total weight of true variables; returns a Sat::RESULT_*.
+	int optimise(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		const std::vector<int64_t>& weights, bool maximise, solver::PartialAssignment* out, int64_t* cost,
+		solver::Job& job)
+	{
+		// maximising is just minimising the negated weights.
+		auto costs = std::vector<int64_t>();
+		for(auto w : weights)
+			costs.push_back(maximise ? -w : w);
+
+		auto r = reduce(expr, vars, pins, GOAL_CHEAPEST, &costs);
+
+		// the forced variables only add a constant.
+		int64_t base = 0;
+		auto free_weights = std::vector<int64_t>();
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			auto w = costs[i];
+			if(!r.forced.isAssigned(i))
+				free_weights.push_back(w);
+			else if(r.forced.get(i))
+				base += w;
+		}
+
+		job.setProgress(0, 0);
+
+		auto soln = solver::Assignment();
+		auto ret = solver::minimiseWeight(r.expr, r.freeVars, free_weights, &soln, cost, job.interruptor());
+		delete r.expr;
+
+		if(ret != solver::Sat::RESULT_SAT)
+			return ret;
+
+		*out = r.expand(solver::PartialAssignment(soln));
+
+		*cost += base;
+		if(maximise)
+			*cost = -*cost;
+
+		return ret;
+	}
+
+	// looks for an assignment (agreeing with the pins) that makes the expression false; returns STEP_FOUND
+	// with it in `out`, or STEP_END if the expression is valid.
+	int find_counterexample(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::PartialAssignment* out, solver::Job& job)
+	{
+		// the expression is only borrowed, so it mustn't get deleted along with the not.
+		auto negated = ast::Not(expr);
+		auto r = reduce(&negated, vars, pins, GOAL_ANY);
+		negated.e = nullptr;
+
+		auto cursor = solver::satCursor(r.expr, r.freeVars);
+		delete r.expr;
+
+		auto ret = step_solver(cursor, /* forward: */ true, job);
+		if(ret == solver::Cursor::STEP_FOUND)
+			*out = r.expand(solver::PartialAssignment(cursor->values()));
+
+		delete cursor;
+		return ret;
+	}
+
+	// whether the two expressions are the same function; if not, `out` gets an assignment (of `vars`,
+	// which should have the variables of both) where they differ. returns one of the solver::EQUIV_* values.
+	int check_equivalent(ast::Expr* a, ast::Expr* b, const std::vector<std::string>& vars,
+		solver::PartialAssignment* out, solver::Job& job)
+	{
+		auto witness = solver::Assignment();
+		auto ret = solver::checkEquivalence(a, b, vars, &witness, job.interruptor());
+		if(ret == solver::EQUIV_DIFFERENT)
+			*out = solver::PartialAssignment(witness);
+
+		return ret;
+	}
+
+	// the variables that are the same in every solution; returns one of the solver::Sat::RESULT_* values.
+	int find_backbone(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		solver::PartialAssignment* out, solver::Job& job)
+	{
+		return solver::findBackbone(expr, vars, pins, out, job.interruptor());
+	}
+
+	// how many solutions each variable is true in, and the total; returns false if cancelled, or if a count ran out of room.
+	bool count_marginals(ast::Expr* expr, const std::vector<std::string>& vars, const solver::PartialAssignment& pins,
+		std::vector<solver::BigNum>* out, solver::BigNum* total, solver::Job& job)
+	{
+		if(!count_models(expr, vars, pins, total, job))
+			return false;
+
+		out->clear();
+		out->resize(vars.size());
+
+		for(size_t i = 0; i < vars.size(); i++)
+		{
+			job.setProgress(i, vars.size());
+			if(pins.isAssigned(i))
 			{
-				ass[v] = (i & (1 << k));
-				k++;
+				(*out)[i] = pins.get(i) ? *total : solver::BigNum(0);
+				continue;
 			}
 
-			auto v = expr->evaluate(ass);
-			if(auto l = dynamic_cast<ast::Lit*>(v); l != nullptr && l->value)
-				solns.push_back(std::move(ass));
+			auto p = pins;
+			p.set(i, true);
 
-			delete v;
-			progress.first = i;
+			if(!count_models(expr, vars, p, &(*out)[i], job))
+				return false;
 		}
 
-		progress.first = progress.second;
-		return solns;
+		job.setProgress(vars.size(), vars.size());
+		return true;
 	}
 }